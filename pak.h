@@ -24,6 +24,9 @@
             - PAK Math, utilities for doing things with numbers
             - PAK Lists, generic linked list library
             - PAK Arrays, generic dynamic array library
+            - PAK Deques, generic ring buffer double ended queue library
+            - PAK Segmented Arrays, generic chunked arrays with stable addresses
+            - PAK Bits, packed bit array library
             - PAK I/O, file input and output library
 
         More are always on the way.
@@ -33,8 +36,11 @@
         Libraries can be disabled with defines before including this file
 
             #define PAK_NO_MATH // Disable math library
-            #define PAK_NO_LIST // Disable linked list library
+            #define PAK_NO_LIST // Disable linked list libraries
             #define PAK_NO_ARR  // Disable dynamic array library
+            #define PAK_NO_DEQUE // Disable deque library
+            #define PAK_NO_SEGARR // Disable segmented array library
+            #define PAK_NO_BITS // Disable bit array library
             #define PAK_NO_IO   // Disable I/O library
 
         Some of the libraries rely on each other, so if there is ever a conflict where
@@ -91,6 +97,40 @@
         in order to provide support for C++, so depending on your compiler, you
         may get references to undefined functions without warning!
 
+    Allocators:
+
+        Arrays, lists and dictionaries can also be given their own allocator when
+        they are created, so that some containers can live in an arena while the
+        rest go through pak_malloc. An allocator is a small vtable:
+
+            typedef struct {
+                void *(*alloc)(void *ctx, size_t sz);
+                void *(*realloc)(void *ctx, void *p, size_t sz);
+                void  (*free)(void *ctx, void *p);
+                void *ctx;
+            } pak_allocator;
+
+        Pass it to the "_new_alloc" version of the constructor, for example
+        "pak_arr_new_alloc(int, 1024, &arena)" or "int_list_new_alloc(&arena)".
+        The allocator is stored by pointer, so it must outlive the container.
+        A NULL allocator uses the pak_malloc wrappers, which is the default.
+
+        Containers in an arena do not have to be free'd one by one, dropping
+        the whole arena releases them all at once.
+
+    Sizes:
+
+        Every count, capacity and index is a "pak_size", which is an int by default,
+        so containers top out at INT_MAX elements. Define PAK_SIZE_T before including
+        this file (the same way in every file) to make "pak_size" a ptrdiff_t instead:
+
+            #define PAK_SIZE_T
+            #include "pak.h"
+
+        "pak_size" is signed either way, since negative indices count from the back
+        and searches return -1. PAK_SIZE_MAX is its largest value, growing past it or
+        past what a size_t can address fails like any other allocation.
+
     License:
 
                             The MIT License (MIT)
@@ -128,7 +168,17 @@ extern "C" {
 #   define PAK_PREFIX
 #endif
 
+/* For small functions generated by the PAK_INIT_* macros that belong in every file */
+#if defined(__cplusplus) || (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L)
+#   define PAK_INLINE static inline
+#elif defined(__GNUC__) || defined(_MSC_VER)
+#   define PAK_INLINE static __inline
+#else
+#   define PAK_INLINE static
+#endif
+
 #ifdef PAK_VERBOSE
+#   include <stdio.h> /* Assertions are also expanded in the user's files */
 #   define pak_assert(C)\
         if (!(C)) {\
             fprintf(stderr, "PAK Assertion fail (%s:%s:%d) %s.\n",\
@@ -175,21 +225,53 @@ extern "C" {
 #   endif
 #endif
 
+/* POSIX only features need their declarations, which strict ISO C modes hide unless
+   a feature test macro such as _POSIX_C_SOURCE is defined before any include */
+#if !defined(_WIN32) && (!defined(__STRICT_ANSI__) || defined(_POSIX_C_SOURCE) ||\
+        defined(_XOPEN_SOURCE) || defined(_GNU_SOURCE) || defined(_DEFAULT_SOURCE))
+#   define PAK__POSIX
+#endif
+
 #ifdef PAK_IMPLEMENTATION
 #   include <stdio.h>
+#   include <stddef.h> /* offsetof */
 #   include <string.h> /* memcpy */
 #   include <stdarg.h>
 #   include <stdint.h>
 #   include <math.h>
+#   if !defined(PAK_NO_THREADS) && !defined(_WIN32)
+#       include <pthread.h>
+#   endif
+#   if !defined(PAK_NO_MMAP) && defined(PAK__POSIX)
+#       include <sys/mman.h>
+#       include <sys/stat.h>
+#       include <fcntl.h>
+#       include <unistd.h>
+#   endif
 #   ifndef M_PI
 #       define M_PI 3.1415926535
 #   endif
 #else
-#   include <stddef.h> /* size_t */
+#   include <stddef.h> /* size_t, offsetof */
+#   include <stdint.h> /* uint64_t */
 #endif
 
 /* Common types */
 
+/* Counts, capacities and indices of every container. Define PAK_SIZE_T to make them
+   pointer sized, they are plain ints otherwise. Either way they stay signed, so that
+   negative indices and -1 for "not found" keep working */
+#ifdef PAK_SIZE_T
+#   include <stddef.h> /* ptrdiff_t */
+#   include <stdint.h> /* PTRDIFF_MAX */
+    typedef ptrdiff_t pak_size;
+#   define PAK_SIZE_MAX PTRDIFF_MAX
+#else
+#   include <limits.h> /* INT_MAX */
+    typedef int pak_size;
+#   define PAK_SIZE_MAX INT_MAX
+#endif
+
 typedef enum {
     PAK_FALSE = 0,
     PAK_TRUE  = 1
@@ -202,6 +284,41 @@ typedef unsigned char  pak_ui8;
 typedef unsigned short pak_ui16;
 typedef unsigned long  pak_ui32;
 
+/* Allocator interface, see "Allocators" in the documentation above */
+typedef struct {
+    void *(*alloc)(void *ctx, size_t sz);
+    void *(*realloc)(void *ctx, void *p, size_t sz);
+    void  (*free)(void *ctx, void *p);
+    void *ctx;
+} pak_allocator;
+
+/* Allocate through "A", a NULL allocator goes straight to pak_malloc and friends */
+PAK_PREFIX void *pak__alloc(const pak_allocator *a, size_t sz);
+PAK_PREFIX void *pak__realloc(const pak_allocator *a, void *p, size_t sz);
+PAK_PREFIX void pak__free(const pak_allocator *a, void *p);
+
+#ifdef PAK_IMPLEMENTATION
+
+PAK_PREFIX void *pak__alloc(const pak_allocator *a, size_t sz)
+{
+    return a ? a->alloc(a->ctx, sz) : pak_malloc(sz);
+}
+
+PAK_PREFIX void *pak__realloc(const pak_allocator *a, void *p, size_t sz)
+{
+    return a ? a->realloc(a->ctx, p, sz) : pak_realloc(p, sz);
+}
+
+PAK_PREFIX void pak__free(const pak_allocator *a, void *p)
+{
+    if (a)
+        a->free(a->ctx, p);
+    else
+        pak_free(p);
+}
+
+#endif /* PAK_IMPLEMENTATION */
+
 /*
     PAK Math:
 
@@ -323,12 +440,38 @@ PAK_PREFIX float pak_math_rad_to_deg(float rad)
    PAK_INIT_LIST will define the following:
 
         <name> <name>_new(void);
+        <name> <name>_new_alloc(const pak_allocator *alloc);
+        <name> <name>_new_pool(pak_pool pool);
         void <name>_free(<name> *pp);
         int  <name>_push(<name> list, <type> data);
         int  <name>_unshift(<name> list, <type> data);
         void <name>_pop(<name> list);
         void <name>_shift(<name> list);
-        <name>_node *<name>_get(<name> list, int index);
+        <name>_node *<name>_get(<name> list, pak_size index);
+        int  <name>_splice(<name> dst, <name> src);
+        int  <name>_splice_after(<name> dst, <name>_node *pos, <name> src);
+        int  <name>_concat(<name> dst, <name> src);
+        int  <name>_move_node(<name> dst, <name> src, <name>_node *node);
+        <name> <name>_split_at(<name> list, <name>_node *node);
+
+   Lists can be sorted in place, without allocating, by generating a stable
+   merge sort with PAK_INIT_LIST_SORT. "LESS(a, b)" is inlined and must be a
+   macro or function returning true when "a" goes before "b":
+
+        #define int_less(A, B) ((A) < (B))
+        PAK_INIT_LIST_SORT(int_list, int, int_less)
+
+        void <name>_sort(<name> list);
+
+   As with the list itself, a header can declare the sort with
+   PAK_INIT_LIST_SORT_PROTOTYPES(int_list) and leave PAK_INIT_LIST_SORT to a
+   single source file.
+
+   The sort relinks the nodes rather than moving data, so pointers to nodes
+   stay valid, but it is not faster than copying the data out: it chases one
+   pointer per comparison, while qsort works on a contiguous buffer. For a
+   large list of small elements, copying out, sorting with qsort and writing
+   the data back into the nodes takes less time, at the cost of a buffer.
 
    The "<name>_get" function takes in an index and fetchs the corresponding
    node in the list.
@@ -337,6 +480,128 @@ PAK_PREFIX float pak_math_rad_to_deg(float rad)
    which will essentially fetch the nodes backwards "-1" will map to the last node,
    "-2" to the second-to-last, etc.
 
+   Node Pools:
+
+        Nodes are not malloc'd one by one, every list carves them out of slabs
+        from a "pak_pool" and keeps popped nodes on a free list for the next
+        push. Slabs start at PAK_LIST_SLAB_MIN nodes and double up to
+        PAK_LIST_SLAB_MAX, and "<name>_free" gives them back all at once.
+
+        By default every list has a pool of its own. Lists of the same type can
+        share one instead, so nodes freed by one list are reused by the others:
+
+            pak_pool pool = pak_pool_new(sizeof(int_list_node), NULL);
+            int_list a = int_list_new_pool(pool);
+            int_list b = int_list_new_pool(pool);
+            pak_pool_free(&pool); // The lists keep it alive until they are freed
+
+        A pool's slabs are released once its last list is freed, so a list which
+        shares a pool returns its nodes to the free list instead. Pools are not
+        thread safe, lists on different threads need pools of their own.
+
+   Moving Nodes:
+
+        Nodes can move between lists without being freed and allocated again,
+        only relinked. "<name>_splice" (or "<name>_concat", the same function)
+        moves every node of "src" to the back of "dst" in O(1), leaving "src"
+        empty, and "<name>_splice_after" moves them in after "pos" instead, or
+        to the front if "pos" is NULL. "<name>_move_node" moves one node of
+        "src" to the back of "dst", also in O(1):
+
+            while (... some jobs are done ...)
+                job_list_move_node(done, pending, node);
+            job_list_concat(archive, done);
+
+        "<name>_split_at" cuts "node" and everything after it off into a new
+        list, counting whichever side of "node" is shorter. The new list is the
+        only allocation, and has to be freed too.
+
+        Relinking is only O(1) between lists sharing a pool, created with
+        "<name>_new_pool", since a list frees its pool's slabs. Lists made by
+        "<name>_new" have pools of their own, so between them the data is
+        copied into nodes of the pool of "dst" one node at a time instead, and
+        pointers to the moved nodes of "src" are no longer valid. If a copy
+        fails to get a node the function returns -1, with the nodes copied so
+        far in "dst" and the rest still in "src".
+
+   Unrolled Lists:
+
+        A list of small elements spends most of its memory, and most of a
+        traversal, on node pointers. PAK_INIT_ULIST takes the same arguments
+        but stores a small array of elements in every node, as many as fit in
+        PAK_ULIST_NODE_SZ bytes (128 by default, two cache lines), so walking
+        it is a plain loop over each node's array:
+
+            PAK_INIT_ULIST(int_ulist, int, (void))
+
+            <name>  <name>_new     (void);
+            <name>  <name>_new_alloc(const pak_allocator *alloc);
+            <name>  <name>_new_pool(pak_pool pool);
+            void    <name>_free    (<name> *pp);
+            int     <name>_push    (<name> list, <type> data);
+            int     <name>_unshift (<name> list, <type> data);
+            void    <name>_pop     (<name> list);
+            void    <name>_shift   (<name> list);
+            <type> *<name>_get     (<name> list, pak_size index);
+            int     <name>_insert  (<name> list, pak_size index, <type> data);
+            int     <name>_erase   (<name> list, pak_size index);
+
+            int_ulist_node *n;
+            int i;
+            pak_ulist_foreach(list, n, i)
+                sum += n->data[i];
+
+        "<name>_get" returns a pointer to the element rather than a node, and
+        skips whole nodes at a time. Inserting into a full node splits it in
+        two, and erasing from a node less than half full merges it with the
+        next one when they fit in one. Elements move around within and between
+        nodes, so pointers to them only last until the next insert or erase.
+
+   Intrusive Lists:
+
+        PAK_INIT_ILIST links structs which carry their own "pak_ilist_link",
+        so nothing is copied or allocated per element and an element can sit
+        on as many lists as it has links:
+
+            struct job {
+                int id;
+                pak_ilist_link queue;  // For job_queue
+                pak_ilist_link owner;  // For job_list
+            };
+
+            PAK_INIT_ILIST(job_queue, struct job, queue)
+            PAK_INIT_ILIST(job_list, struct job, owner)
+
+            <name>    <name>_new          (void);
+            <name>    <name>_new_alloc    (const pak_allocator *alloc);
+            void      <name>_init         (<name> list);
+            void      <name>_free         (<name> *pp);
+            void      <name>_push         (<name> list, <struct> *elem);
+            void      <name>_unshift      (<name> list, <struct> *elem);
+            <struct> *<name>_pop          (<name> list);
+            <struct> *<name>_shift        (<name> list);
+            void      <name>_insert_after (<name> list, <struct> *pos, <struct> *elem);
+            void      <name>_insert_before(<name> list, <struct> *pos, <struct> *elem);
+            void      <name>_remove       (<name> list, <struct> *elem);
+            int       <name>_linked       (const <struct> *elem);
+            <struct> *<name>_first        (<name> list);
+            <struct> *<name>_last         (<name> list);
+            <struct> *<name>_next         (<name> list, <struct> *elem);
+            <struct> *<name>_prev         (<name> list, <struct> *elem);
+
+        "<name>_remove" unlinks any element in O(1) without searching for it,
+        and clears its link so "<name>_linked" tells whether it is on the list,
+        which also holds for zeroed structs. Pops, shifts, first, last, next and
+        prev return NULL past the ends. Everything but new and free is static
+        inline, and "<name>_init" sets up a "<name>_" embedded elsewhere instead
+        of allocating one. Freeing a list unlinks its elements but never frees
+        them. To loop, removing elements as you go:
+
+            struct job *j, *tmp;
+            pak_ilist_foreach(job_queue, queue, j, tmp)
+                if (j->id < 0)
+                    job_queue_remove(queue, j);
+
    Example:
 
         PAK_INIT_LIST(int_list, int, (void))
@@ -350,13 +615,13 @@ PAK_PREFIX float pak_math_rad_to_deg(float rad)
                 int_list_push(list, i);
 
             for (i = 0; i < 1024; i++)
-                int_list_pop(list, i);
+                int_list_pop(list);
 
             for (i = 0; i < 1024; i++)
                 int_list_unshift(list, i);
 
             for (i = 0; i < 1024; i++)
-                int_list_shift(list, i);
+                int_list_shift(list);
 
             int_list_free(&list);
             return 0;
@@ -365,241 +630,1164 @@ PAK_PREFIX float pak_math_rad_to_deg(float rad)
 
 #ifndef PAK_NO_LIST
 
+#ifndef PAK_LIST_SLAB_MIN
+#   define PAK_LIST_SLAB_MIN 16
+#endif
+
+#ifndef PAK_LIST_SLAB_MAX
+#   define PAK_LIST_SLAB_MAX 4096
+#endif
+
+/* Kept at the end of every slab, so the nodes start on the allocator's alignment */
+typedef struct pak__pool_slab {
+    struct pak__pool_slab *prev;
+    void *base;
+} pak__pool_slab;
+
+typedef struct {
+    void *spare;            /* Freed nodes, linked through their first bytes */
+    char *fresh;            /* Never used nodes of the newest slab */
+    char *end;
+    pak__pool_slab *slabs;
+    size_t node_sz;
+    pak_size slab;          /* Nodes in the next slab */
+    int refs;               /* Lists using the pool, plus one for its creator */
+    const pak_allocator *alloc;
+} pak_pool_;
+
+typedef pak_pool_* pak_pool;
+
+PAK_PREFIX pak_pool pak_pool_new(size_t node_sz, const pak_allocator *alloc);
+PAK_PREFIX void pak_pool_free(pak_pool *pp);
+PAK_PREFIX void *pak__pool_grow(pak_pool pool);
+
+PAK_INLINE void *pak__pool_get(pak_pool pool)
+{
+    void *node = pool->spare;
+
+    if (node) {
+        pool->spare = *(void **)node;
+        return node;
+    }
+
+    if (pool->fresh != pool->end) {
+        node = pool->fresh;
+        pool->fresh += pool->node_sz;
+        return node;
+    }
+
+    return pak__pool_grow(pool);
+}
+
+PAK_INLINE void pak__pool_put(pak_pool pool, void *node)
+{
+    *(void **)node = pool->spare;
+    pool->spare = node;
+}
+
+#ifdef PAK_IMPLEMENTATION
+PAK_PREFIX pak_pool pak_pool_new(size_t node_sz, const pak_allocator *alloc)
+{
+    pak_pool pool = NULL;
+
+    pak_assert(node_sz > 0);
+
+    pool = (pak_pool)pak__alloc(alloc, sizeof(*pool));
+    pak_assert(pool);
+
+    /* The free list and the slab trailers are stored in place of nodes */
+    if (node_sz < sizeof(void *))
+        node_sz = sizeof(void *);
+    node_sz = (node_sz + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+
+    pool->spare = NULL;
+    pool->fresh = NULL;
+    pool->end = NULL;
+    pool->slabs = NULL;
+    pool->node_sz = node_sz;
+    pool->slab = PAK_LIST_SLAB_MIN;
+    pool->refs = 1;
+    pool->alloc = alloc;
+
+    return pool;
+
+fail:
+    return NULL;
+}
+
+/* Drops one reference, the slabs go once nothing uses the pool */
+PAK_PREFIX void pak_pool_free(pak_pool *pp)
+{
+    pak_pool pool = *pp;
+
+    pak_assert(pool); /* Double free? */
+    *pp = NULL;
+
+    if (--pool->refs > 0)
+        return;
+
+    while (pool->slabs) {
+        pak__pool_slab *prev = pool->slabs->prev;
+        pak__free(pool->alloc, pool->slabs->base);
+        pool->slabs = prev;
+    }
+
+    pak__free(pool->alloc, pool);
+
+fail:
+    return;
+}
+
+PAK_PREFIX void *pak__pool_grow(pak_pool pool)
+{
+    pak__pool_slab *slab = NULL;
+    char *base = NULL;
+    size_t len;
+
+    pak_assert((size_t)pool->slab <= ((size_t)-1 - sizeof(*slab)) / pool->node_sz);
+    len = pool->node_sz * pool->slab;
+
+    base = (char *)pak__alloc(pool->alloc, len + sizeof(*slab));
+    pak_assert(base);
+
+    slab = (pak__pool_slab *)(base + len);
+    slab->prev = pool->slabs;
+    slab->base = base;
+    pool->slabs = slab;
+
+    /* Hand out the first node right away */
+    pool->fresh = base + pool->node_sz;
+    pool->end = base + len;
+
+    if (pool->slab < PAK_LIST_SLAB_MAX)
+        pool->slab *= 2;
+
+    return base;
+
+fail:
+    return NULL;
+}
+#endif /* PAK_IMPLEMENTATION */
+
+#define PAK__INIT_LIST_TYPE(NAME, TYPE)                                             \
+    typedef struct NAME##_node {                                                    \
+        TYPE data;                                                                  \
+        struct NAME##_node *next;                                                   \
+        struct NAME##_node *prev;                                                   \
+    } NAME##_node;                                                                  \
+                                                                                    \
+    typedef struct {                                                                \
+        pak_size count;                                                             \
+        NAME##_node *first;                                                         \
+        NAME##_node *last;                                                          \
+        pak_pool pool;                                                              \
+        const pak_allocator *alloc;                                                 \
+    } NAME##_;                                                                      \
+                                                                                    \
+    typedef NAME##_* NAME;
+
 /* For header files */
-#define PAK_INIT_LIST_PROTOTYPES(NAME, TYPE)        \
-    typedef struct NAME##_node {                    \
-        TYPE data;                                  \
-        struct NAME##_node *next;                   \
-        struct NAME##_node *prev;                   \
-    } NAME##_node;                                  \
-                                                    \
-    typedef struct {                                \
-        int count;                                  \
-        NAME##_node *first;                         \
-        NAME##_node *last;                          \
-    } NAME##_;                                      \
-                                                    \
-    typedef NAME##_* NAME;                          \
-                                                    \
-    extern NAME NAME##_new(void);                   \
-    extern void NAME##_free(NAME *pp);              \
-    extern int NAME##_push(NAME list, TYPE data);   \
-    extern int NAME##_unshift(NAME list, TYPE data);\
-    extern void NAME##_pop(NAME list);              \
-    extern void NAME##_shift(NAME list);
-
-#define PAK_INIT_LIST(NAME, TYPE, FREE)                 \
-    typedef struct NAME##_node {                        \
-        TYPE data;                                      \
-        struct NAME##_node *next;                       \
-        struct NAME##_node *prev;                       \
-    } NAME##_node;                                      \
-                                                        \
-    typedef struct {                                    \
-        int count;                                      \
-        NAME##_node *first;                             \
-        NAME##_node *last;                              \
-    } NAME##_;                                          \
-                                                        \
-    typedef NAME##_* NAME;                              \
-                                                        \
-    NAME NAME##_new(void)                               \
-    {                                                   \
-        NAME list = (NAME)pak_malloc(sizeof(*list));    \
-        pak_assert(list);                               \
-                                                        \
-        list->count = 0;                                \
-        list->first = NULL;                             \
-        list->last = NULL;                              \
-                                                        \
-        return list;                                    \
-                                                        \
-    fail:                                               \
-        return NULL;                                    \
-    }                                                   \
-                                                        \
-    void NAME##_free(NAME *pp)                          \
-    {                                                   \
-        int i;                                          \
-        NAME list = NULL;                               \
-        NAME##_node *curr = NULL;                       \
-                                                        \
-        list = *pp;                                     \
-        pak_assert(list); /* Double free? */            \
-                                                        \
-        curr = list->first;                             \
-                                                        \
-        while (curr && list->count > 0) {               \
-            NAME##_node *tmp = curr->next;              \
-                                                        \
-            FREE(curr->data);                           \
-            pak_free(curr);                             \
-                                                        \
-            curr = tmp;                                 \
-            list->count--;                              \
-        }                                               \
-                                                        \
-        pak_free(list);                                 \
-        *pp = NULL;                                     \
-                                                        \
-    fail:                                               \
-        return;                                         \
-    }                                                   \
-                                                        \
-    int NAME##_push(NAME list, TYPE data)               \
-    {                                                   \
-        NAME##_node *node = NULL;                       \
-                                                        \
-        node = (NAME##_node *)pak_malloc(sizeof(*node));\
-        pak_assert(node);                               \
-                                                        \
-        node->next = NULL;                              \
-        node->prev = NULL;                              \
-        node->data = data;                              \
-                                                        \
-        if (list->count == 0) {                         \
-            list->first = node;                         \
-            list->last = node;                          \
-        } else {                                        \
-            list->last->next = node;                    \
-            node->prev = list->last;                    \
-            list->last = node;                          \
-        }                                               \
-                                                        \
-        list->count++;                                  \
-                                                        \
-        return 0;                                       \
-                                                        \
-    fail:                                               \
-        return -1;                                      \
-    }                                                   \
-                                                        \
-    void NAME##_pop(NAME list)                          \
-    {                                                   \
-        NAME##_node *last = NULL;                       \
-        NAME##_node *prev = NULL;                       \
-                                                        \
-        pak_assert(list->count > 0);                    \
-        pak_assert(list->last);                         \
-                                                        \
-        last = list->last;                              \
-        prev = last->prev;                              \
-                                                        \
-        FREE(last->data);                               \
-        pak_free(last);                                 \
-                                                        \
-        if (prev) {                                     \
-            list->last = prev;                          \
-            prev->next = NULL;                          \
-        } else {                                        \
-            list->first = NULL;                         \
-            list->last = NULL;                          \
-        }                                               \
-                                                        \
-        list->count--;                                  \
-                                                        \
-    fail:                                               \
-        return;                                         \
-    }                                                   \
-                                                        \
-    int NAME##_unshift(NAME list, TYPE data)            \
-    {                                                   \
-        NAME##_node *node = NULL;                       \
-                                                        \
-        node = (NAME##_node*)pak_malloc(sizeof(*node)); \
-        pak_assert(node);                               \
-                                                        \
-        node->next = NULL;                              \
-        node->prev = NULL;                              \
-        node->data = data;                              \
-                                                        \
-        if (list->count == 0) {                         \
-            list->first = node;                         \
-            list->last = node;                          \
-        } else {                                        \
-            list->first->prev = node;                   \
-            node->next = list->first;                   \
-            list->first = node;                         \
-        }                                               \
-                                                        \
-        list->count++;                                  \
-                                                        \
-        return 0;                                       \
-                                                        \
-    fail:                                               \
-        return -1;                                      \
-    }                                                   \
-                                                        \
-    void NAME##_shift(NAME list)                        \
-    {                                                   \
-        NAME##_node *first = NULL;                      \
-        NAME##_node *next = NULL;                       \
-                                                        \
-        pak_assert(list->count > 0);                    \
-        pak_assert(list->first);                        \
-                                                        \
-        first = list->first;                            \
-        next = first->next;                             \
-                                                        \
-        FREE(first->data);                              \
-        pak_free(first);                                \
-                                                        \
-        if (next) {                                     \
-            list->first = next;                         \
-            next->prev = NULL;                          \
-        } else {                                        \
-            list->first = NULL;                         \
-            list->last = NULL;                          \
-        }                                               \
-                                                        \
-        list->count--;                                  \
-                                                        \
-    fail:                                               \
-        return;                                         \
-    }                                                   \
-                                                        \
-    NAME##_node *NAME##_get(NAME list, int index)       \
-    {                                                   \
-        NAME##_node *curr = NULL;                       \
-        int mid, pos;                                   \
-                                                        \
-        /* Take in negative values, explained in docs */\
-        if (index < 0)                                  \
-            index = list->count + index;                \
-                                                        \
-        pak_assert(0 < index && index < list->count);   \
-                                                        \
-        /* Find shortest path possible */               \
-        mid = list->count/2;                            \
-                                                        \
-        if (index <= mid) {                             \
-            pos = 1;                                    \
-            curr = list->first;                         \
-                                                        \
-            while (curr && pos < index) {               \
-                curr = curr->next;                      \
-                pos++;                                  \
-            }                                           \
-        } else {                                        \
-            pos = list->count - 1;                      \
-            curr = list->last;                          \
-                                                        \
-            while (curr && pos > index) {               \
-                curr = curr->prev;                      \
-                pos--;                                  \
-            }                                           \
-        }                                               \
-                                                        \
-        pak_assert(pos == index);                       \
-        return curr;                                    \
-                                                        \
-    fail:                                               \
-        return NULL;                                    \
+#define PAK_INIT_LIST_PROTOTYPES(NAME, TYPE)                                        \
+    PAK__INIT_LIST_TYPE(NAME, TYPE)                                                 \
+                                                                                    \
+    extern NAME NAME##_new(void);                                                   \
+    extern NAME NAME##_new_alloc(const pak_allocator *alloc);                       \
+    extern NAME NAME##_new_pool(pak_pool pool);                                     \
+    extern void NAME##_free(NAME *pp);                                              \
+    extern int NAME##_push(NAME list, TYPE data);                                   \
+    extern int NAME##_unshift(NAME list, TYPE data);                                \
+    extern void NAME##_pop(NAME list);                                              \
+    extern void NAME##_shift(NAME list);                                            \
+    extern NAME##_node *NAME##_get(NAME list, pak_size index);                      \
+    extern int NAME##_splice(NAME dst, NAME src);                                   \
+    extern int NAME##_splice_after(NAME dst, NAME##_node *pos, NAME src);           \
+    extern int NAME##_concat(NAME dst, NAME src);                                   \
+    extern int NAME##_move_node(NAME dst, NAME src, NAME##_node *node);             \
+    extern NAME NAME##_split_at(NAME list, NAME##_node *node);
+
+#define PAK_INIT_LIST(NAME, TYPE, FREE)                                             \
+    PAK__INIT_LIST_TYPE(NAME, TYPE)                                                 \
+                                                                                    \
+    /* The list holds a reference to the pool, see "Node Pools" above */            \
+    PAK_PREFIX NAME NAME##_new_pool(pak_pool pool)                                  \
+    {                                                                               \
+        NAME list = NULL;                                                           \
+                                                                                    \
+        pak_assert(pool && pool->node_sz >= sizeof(NAME##_node));                   \
+                                                                                    \
+        list = (NAME)pak__alloc(pool->alloc, sizeof(*list));                        \
+        pak_assert(list);                                                           \
+                                                                                    \
+        list->count = 0;                                                            \
+        list->first = NULL;                                                         \
+        list->last = NULL;                                                          \
+        list->pool = pool;                                                          \
+        list->alloc = pool->alloc;                                                  \
+                                                                                    \
+        pool->refs++;                                                               \
+                                                                                    \
+        return list;                                                                \
+                                                                                    \
+    fail:                                                                           \
+        return NULL;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new_alloc(const pak_allocator *alloc)                    \
+    {                                                                               \
+        pak_pool pool = pak_pool_new(sizeof(NAME##_node), alloc);                   \
+        NAME list = NULL;                                                           \
+                                                                                    \
+        pak_assert(pool);                                                           \
+                                                                                    \
+        list = NAME##_new_pool(pool);                                               \
+        pak_pool_free(&pool);                                                       \
+                                                                                    \
+    fail:                                                                           \
+        return list;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new(void)                                                \
+    {                                                                               \
+        return NAME##_new_alloc(NULL);                                              \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX void NAME##_free(NAME *pp)                                           \
+    {                                                                               \
+        NAME list = NULL;                                                           \
+        NAME##_node *curr = NULL;                                                   \
+        int shared;                                                                 \
+                                                                                    \
+        list = *pp;                                                                 \
+        pak_assert(list); /* Double free? */                                        \
+                                                                                    \
+        /* Nodes of a private pool go away with its slabs */                        \
+        shared = list->pool->refs > 1;                                              \
+        curr = list->first;                                                         \
+                                                                                    \
+        while (curr) {                                                              \
+            NAME##_node *tmp = curr->next;                                          \
+                                                                                    \
+            FREE(curr->data);                                                       \
+            if (shared)                                                             \
+                pak__pool_put(list->pool, curr);                                    \
+                                                                                    \
+            curr = tmp;                                                             \
+        }                                                                           \
+                                                                                    \
+        pak_pool_free(&list->pool);                                                 \
+        pak__free(list->alloc, list);                                               \
+        *pp = NULL;                                                                 \
+                                                                                    \
+    fail:                                                                           \
+        return;                                                                     \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_push(NAME list, TYPE data)                                \
+    {                                                                               \
+        NAME##_node *node = NULL;                                                   \
+                                                                                    \
+        node = (NAME##_node *)pak__pool_get(list->pool);                            \
+        pak_assert(node);                                                           \
+                                                                                    \
+        node->next = NULL;                                                          \
+        node->prev = NULL;                                                          \
+        node->data = data;                                                          \
+                                                                                    \
+        if (list->count == 0) {                                                     \
+            list->first = node;                                                     \
+            list->last = node;                                                      \
+        } else {                                                                    \
+            list->last->next = node;                                                \
+            node->prev = list->last;                                                \
+            list->last = node;                                                      \
+        }                                                                           \
+                                                                                    \
+        list->count++;                                                              \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX void NAME##_pop(NAME list)                                           \
+    {                                                                               \
+        NAME##_node *last = NULL;                                                   \
+        NAME##_node *prev = NULL;                                                   \
+                                                                                    \
+        pak_assert(list->count > 0);                                                \
+        pak_assert(list->last);                                                     \
+                                                                                    \
+        last = list->last;                                                          \
+        prev = last->prev;                                                          \
+                                                                                    \
+        FREE(last->data);                                                           \
+        pak__pool_put(list->pool, last);                                            \
+                                                                                    \
+        if (prev) {                                                                 \
+            list->last = prev;                                                      \
+            prev->next = NULL;                                                      \
+        } else {                                                                    \
+            list->first = NULL;                                                     \
+            list->last = NULL;                                                      \
+        }                                                                           \
+                                                                                    \
+        list->count--;                                                              \
+                                                                                    \
+    fail:                                                                           \
+        return;                                                                     \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_unshift(NAME list, TYPE data)                             \
+    {                                                                               \
+        NAME##_node *node = NULL;                                                   \
+                                                                                    \
+        node = (NAME##_node *)pak__pool_get(list->pool);                            \
+        pak_assert(node);                                                           \
+                                                                                    \
+        node->next = NULL;                                                          \
+        node->prev = NULL;                                                          \
+        node->data = data;                                                          \
+                                                                                    \
+        if (list->count == 0) {                                                     \
+            list->first = node;                                                     \
+            list->last = node;                                                      \
+        } else {                                                                    \
+            list->first->prev = node;                                               \
+            node->next = list->first;                                               \
+            list->first = node;                                                     \
+        }                                                                           \
+                                                                                    \
+        list->count++;                                                              \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX void NAME##_shift(NAME list)                                         \
+    {                                                                               \
+        NAME##_node *first = NULL;                                                  \
+        NAME##_node *next = NULL;                                                   \
+                                                                                    \
+        pak_assert(list->count > 0);                                                \
+        pak_assert(list->first);                                                    \
+                                                                                    \
+        first = list->first;                                                        \
+        next = first->next;                                                         \
+                                                                                    \
+        FREE(first->data);                                                          \
+        pak__pool_put(list->pool, first);                                           \
+                                                                                    \
+        if (next) {                                                                 \
+            list->first = next;                                                     \
+            next->prev = NULL;                                                      \
+        } else {                                                                    \
+            list->first = NULL;                                                     \
+            list->last = NULL;                                                      \
+        }                                                                           \
+                                                                                    \
+        list->count--;                                                              \
+                                                                                    \
+    fail:                                                                           \
+        return;                                                                     \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX NAME##_node *NAME##_get(NAME list, pak_size index)                   \
+    {                                                                               \
+        NAME##_node *curr = NULL;                                                   \
+        pak_size pos;                                                               \
+                                                                                    \
+        /* Take in negative values, explained in docs */                            \
+        if (index < 0)                                                              \
+            index = list->count + index;                                            \
+                                                                                    \
+        pak_assert(0 <= index && index < list->count);                              \
+                                                                                    \
+        /* Find shortest path possible */                                           \
+        if (index <= list->count / 2) {                                             \
+            curr = list->first;                                                     \
+            for (pos = 0; pos < index; pos++)                                       \
+                curr = curr->next;                                                  \
+        } else {                                                                    \
+            curr = list->last;                                                      \
+            for (pos = list->count - 1; pos > index; pos--)                         \
+                curr = curr->prev;                                                  \
+        }                                                                           \
+                                                                                    \
+        return curr;                                                                \
+                                                                                    \
+    fail:                                                                           \
+        return NULL;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE void NAME##__unlink(NAME list, NAME##_node *node)                    \
+    {                                                                               \
+        if (node->prev)                                                             \
+            node->prev->next = node->next;                                          \
+        else                                                                        \
+            list->first = node->next;                                               \
+                                                                                    \
+        if (node->next)                                                             \
+            node->next->prev = node->prev;                                          \
+        else                                                                        \
+            list->last = node->prev;                                                \
+                                                                                    \
+        list->count--;                                                              \
+    }                                                                               \
+                                                                                    \
+    /* Links "node" in after "pos", or at the front if "pos" is NULL */             \
+    PAK_INLINE void NAME##__link_after(NAME list, NAME##_node *pos,                 \
+                                       NAME##_node *node)                           \
+    {                                                                               \
+        node->prev = pos;                                                           \
+        node->next = pos ? pos->next : list->first;                                 \
+                                                                                    \
+        if (node->prev)                                                             \
+            node->prev->next = node;                                                \
+        else                                                                        \
+            list->first = node;                                                     \
+                                                                                    \
+        if (node->next)                                                             \
+            node->next->prev = node;                                                \
+        else                                                                        \
+            list->last = node;                                                      \
+                                                                                    \
+        list->count++;                                                              \
+    }                                                                               \
+                                                                                    \
+    /* Moves the data of "node" into a node of the pool of "dst", after "pos" */    \
+    static NAME##_node *NAME##__copy_after(NAME dst, NAME##_node *pos, NAME src,    \
+                                           NAME##_node *node)                       \
+    {                                                                               \
+        NAME##_node *copy = (NAME##_node *)pak__pool_get(dst->pool);                \
+                                                                                    \
+        if (!copy)                                                                  \
+            return NULL;                                                            \
+                                                                                    \
+        copy->data = node->data;                                                    \
+        NAME##__unlink(src, node);                                                  \
+        pak__pool_put(src->pool, node);                                             \
+        NAME##__link_after(dst, pos, copy);                                         \
+                                                                                    \
+        return copy;                                                                \
+    }                                                                               \
+                                                                                    \
+    /* O(1) between lists of one pool, otherwise the nodes are copied one by one */ \
+    PAK_PREFIX int NAME##_splice_after(NAME dst, NAME##_node *pos, NAME src)        \
+    {                                                                               \
+        NAME##_node *next = NULL;                                                   \
+                                                                                    \
+        pak_assert(dst != src);                                                     \
+                                                                                    \
+        if (src->count == 0)                                                        \
+            return 0;                                                               \
+                                                                                    \
+        if (dst->pool != src->pool) {                                               \
+            while (src->first) {                                                    \
+                pos = NAME##__copy_after(dst, pos, src, src->first);                \
+                pak_assert(pos);                                                    \
+            }                                                                       \
+                                                                                    \
+            return 0;                                                               \
+        }                                                                           \
+                                                                                    \
+        next = pos ? pos->next : dst->first;                                        \
+                                                                                    \
+        src->first->prev = pos;                                                     \
+        src->last->next = next;                                                     \
+                                                                                    \
+        if (pos)                                                                    \
+            pos->next = src->first;                                                 \
+        else                                                                        \
+            dst->first = src->first;                                                \
+                                                                                    \
+        if (next)                                                                   \
+            next->prev = src->last;                                                 \
+        else                                                                        \
+            dst->last = src->last;                                                  \
+                                                                                    \
+        dst->count += src->count;                                                   \
+                                                                                    \
+        src->first = NULL;                                                          \
+        src->last = NULL;                                                           \
+        src->count = 0;                                                             \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_splice(NAME dst, NAME src)                                \
+    {                                                                               \
+        return NAME##_splice_after(dst, dst->last, src);                            \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_concat(NAME dst, NAME src)                                \
+    {                                                                               \
+        return NAME##_splice_after(dst, dst->last, src);                            \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_move_node(NAME dst, NAME src, NAME##_node *node)          \
+    {                                                                               \
+        pak_assert(src->count > 0);                                                 \
+                                                                                    \
+        if (dst->pool != src->pool) {                                               \
+            pak_assert(NAME##__copy_after(dst, dst->last, src, node));              \
+            return 0;                                                               \
+        }                                                                           \
+                                                                                    \
+        NAME##__unlink(src, node);                                                  \
+        NAME##__link_after(dst, dst->last, node);                                   \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    /* Cuts "node" and everything after it off into a new list on the same pool */  \
+    PAK_PREFIX NAME NAME##_split_at(NAME list, NAME##_node *node)                   \
+    {                                                                               \
+        NAME tail = NULL;                                                           \
+        NAME##_node *fwd = node;                                                    \
+        NAME##_node *back = node->prev;                                             \
+        pak_size n = 0;                                                             \
+                                                                                    \
+        tail = NAME##_new_pool(list->pool);                                         \
+        pak_assert(tail);                                                           \
+                                                                                    \
+        /* Count whichever side of "node" runs out first */                         \
+        while (fwd && back) {                                                       \
+            fwd = fwd->next;                                                        \
+            back = back->prev;                                                      \
+            n++;                                                                    \
+        }                                                                           \
+                                                                                    \
+        tail->count = fwd ? list->count - n : n;                                    \
+                                                                                    \
+        tail->first = node;                                                         \
+        tail->last = list->last;                                                    \
+        list->last = node->prev;                                                    \
+        list->count -= tail->count;                                                 \
+                                                                                    \
+        if (node->prev)                                                             \
+            node->prev->next = NULL;                                                \
+        else                                                                        \
+            list->first = NULL;                                                     \
+        node->prev = NULL;                                                          \
+                                                                                    \
+        return tail;                                                                \
+                                                                                    \
+    fail:                                                                           \
+        return NULL;                                                                \
+    }
+
+/* Stable bottom-up merge sort, "LESS(a, b)" is a macro or function returning true if a < b */
+#define PAK_INIT_LIST_SORT(NAME, TYPE, LESS)                                        \
+    /* Merges two sorted runs linked through "next", ties go to "a" */              \
+    static NAME##_node *NAME##__merge(NAME##_node *a, NAME##_node *b)               \
+    {                                                                               \
+        NAME##_node *head = NULL;                                                   \
+        NAME##_node **tail = &head;                                                 \
+                                                                                    \
+        while (a && b) {                                                            \
+            if (LESS(b->data, a->data)) {                                           \
+                *tail = b;                                                          \
+                b = b->next;                                                        \
+            } else {                                                                \
+                *tail = a;                                                          \
+                a = a->next;                                                        \
+            }                                                                       \
+            tail = &(*tail)->next;                                                  \
+        }                                                                           \
+                                                                                    \
+        *tail = a ? a : b;                                                          \
+        return head;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX void NAME##_sort(NAME list)                                          \
+    {                                                                               \
+        /* runs[i] is empty or a sorted run of 2^i nodes, older than runs[i - 1] */ \
+        NAME##_node *runs[8 * sizeof(pak_size)];                                    \
+        NAME##_node *node, *next, *carry, *prev;                                    \
+        int i, used = 0;                                                            \
+                                                                                    \
+        if (list->count < 2)                                                        \
+            return;                                                                 \
+                                                                                    \
+        for (node = list->first; node; node = next) {                               \
+            next = node->next;                                                      \
+            node->next = NULL;                                                      \
+            carry = node;                                                           \
+                                                                                    \
+            for (i = 0; i < used && runs[i]; i++) {                                 \
+                carry = NAME##__merge(runs[i], carry);                              \
+                runs[i] = NULL;                                                     \
+            }                                                                       \
+                                                                                    \
+            if (i == used)                                                          \
+                used++;                                                             \
+            runs[i] = carry;                                                        \
+        }                                                                           \
+                                                                                    \
+        for (carry = NULL, i = 0; i < used; i++)                                    \
+            if (runs[i])                                                            \
+                carry = NAME##__merge(runs[i], carry);                              \
+                                                                                    \
+        /* Sorting only followed "next", so put the "prev" links back */            \
+        for (prev = NULL, node = carry; node; prev = node, node = node->next)       \
+            node->prev = prev;                                                      \
+                                                                                    \
+        list->first = carry;                                                        \
+        list->last = prev;                                                          \
     }
 
+/* For header files */
+#define PAK_INIT_LIST_SORT_PROTOTYPES(NAME)                                         \
+    extern void NAME##_sort(NAME list);
+
 /* Looping utilities */
-#define pak_list_foreach(L, N)       for (N = L->first; N != NULL && N->next != NULL; N = N->next)
-#define pak_list_foreach_back(L, N)  for (N = L->last ; N != NULL && N->prev != NULL; N = N->prev)
+#define pak_list_foreach(L, N)       for (N = (L)->first; N != NULL; N = N->next)
+#define pak_list_foreach_back(L, N)  for (N = (L)->last ; N != NULL; N = N->prev)
+
+/* Unrolled lists, see "Unrolled Lists" above */
+#ifndef PAK_ULIST_NODE_SZ
+#   define PAK_ULIST_NODE_SZ 128
+#endif
+
+/* Elements per node, so that a node takes about PAK_ULIST_NODE_SZ bytes */
+#define PAK__ULIST_CAP(TYPE)\
+    ((PAK_ULIST_NODE_SZ - 3 * sizeof(void *)) / sizeof(TYPE) > 1 ?\
+     (int)((PAK_ULIST_NODE_SZ - 3 * sizeof(void *)) / sizeof(TYPE)) : 2)
+
+#define PAK__INIT_ULIST_TYPE(NAME, TYPE)                                            \
+    typedef struct NAME##_node {                                                    \
+        struct NAME##_node *next;                                                   \
+        struct NAME##_node *prev;                                                   \
+        int count;                                                                  \
+        TYPE data[PAK__ULIST_CAP(TYPE)];                                            \
+    } NAME##_node;                                                                  \
+                                                                                    \
+    typedef struct {                                                                \
+        pak_size count;                                                             \
+        NAME##_node *first;                                                         \
+        NAME##_node *last;                                                          \
+        pak_pool pool;                                                              \
+        const pak_allocator *alloc;                                                 \
+    } NAME##_;                                                                      \
+                                                                                    \
+    typedef NAME##_* NAME;
+
+/* For header files */
+#define PAK_INIT_ULIST_PROTOTYPES(NAME, TYPE)                                       \
+    PAK__INIT_ULIST_TYPE(NAME, TYPE)                                                \
+                                                                                    \
+    extern NAME NAME##_new(void);                                                   \
+    extern NAME NAME##_new_alloc(const pak_allocator *alloc);                       \
+    extern NAME NAME##_new_pool(pak_pool pool);                                     \
+    extern void NAME##_free(NAME *pp);                                              \
+    extern int NAME##_push(NAME list, TYPE data);                                   \
+    extern int NAME##_unshift(NAME list, TYPE data);                                \
+    extern void NAME##_pop(NAME list);                                              \
+    extern void NAME##_shift(NAME list);                                            \
+    extern TYPE *NAME##_get(NAME list, pak_size index);                             \
+    extern int NAME##_insert(NAME list, pak_size index, TYPE data);                 \
+    extern int NAME##_erase(NAME list, pak_size index);
+
+#define PAK_INIT_ULIST(NAME, TYPE, FREE)                                            \
+    PAK__INIT_ULIST_TYPE(NAME, TYPE)                                                \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new_pool(pak_pool pool)                                  \
+    {                                                                               \
+        NAME list = NULL;                                                           \
+                                                                                    \
+        pak_assert(pool && pool->node_sz >= sizeof(NAME##_node));                   \
+                                                                                    \
+        list = (NAME)pak__alloc(pool->alloc, sizeof(*list));                        \
+        pak_assert(list);                                                           \
+                                                                                    \
+        list->count = 0;                                                            \
+        list->first = NULL;                                                         \
+        list->last = NULL;                                                          \
+        list->pool = pool;                                                          \
+        list->alloc = pool->alloc;                                                  \
+                                                                                    \
+        pool->refs++;                                                               \
+                                                                                    \
+        return list;                                                                \
+                                                                                    \
+    fail:                                                                           \
+        return NULL;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new_alloc(const pak_allocator *alloc)                    \
+    {                                                                               \
+        pak_pool pool = pak_pool_new(sizeof(NAME##_node), alloc);                   \
+        NAME list = NULL;                                                           \
+                                                                                    \
+        pak_assert(pool);                                                           \
+                                                                                    \
+        list = NAME##_new_pool(pool);                                               \
+        pak_pool_free(&pool);                                                       \
+                                                                                    \
+    fail:                                                                           \
+        return list;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new(void)                                                \
+    {                                                                               \
+        return NAME##_new_alloc(NULL);                                              \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX void NAME##_free(NAME *pp)                                           \
+    {                                                                               \
+        NAME list = NULL;                                                           \
+        NAME##_node *curr = NULL;                                                   \
+        int i, shared;                                                              \
+                                                                                    \
+        list = *pp;                                                                 \
+        pak_assert(list); /* Double free? */                                        \
+                                                                                    \
+        shared = list->pool->refs > 1;                                              \
+        curr = list->first;                                                         \
+                                                                                    \
+        while (curr) {                                                              \
+            NAME##_node *tmp = curr->next;                                          \
+                                                                                    \
+            for (i = 0; i < curr->count; i++)                                       \
+                FREE(curr->data[i]);                                                \
+            if (shared)                                                             \
+                pak__pool_put(list->pool, curr);                                    \
+                                                                                    \
+            curr = tmp;                                                             \
+        }                                                                           \
+                                                                                    \
+        pak_pool_free(&list->pool);                                                 \
+        pak__free(list->alloc, list);                                               \
+        *pp = NULL;                                                                 \
+                                                                                    \
+    fail:                                                                           \
+        return;                                                                     \
+    }                                                                               \
+                                                                                    \
+    /* Links a new, empty node in after "prev", or first if "prev" is NULL */       \
+    static NAME##_node *NAME##__link(NAME list, NAME##_node *prev)                  \
+    {                                                                               \
+        NAME##_node *node = (NAME##_node *)pak__pool_get(list->pool);               \
+        pak_assert(node);                                                           \
+                                                                                    \
+        node->count = 0;                                                            \
+        node->prev = prev;                                                          \
+        node->next = prev ? prev->next : list->first;                               \
+                                                                                    \
+        if (node->next)                                                             \
+            node->next->prev = node;                                                \
+        else                                                                        \
+            list->last = node;                                                      \
+                                                                                    \
+        if (prev)                                                                   \
+            prev->next = node;                                                      \
+        else                                                                        \
+            list->first = node;                                                     \
+                                                                                    \
+        return node;                                                                \
+                                                                                    \
+    fail:                                                                           \
+        return NULL;                                                                \
+    }                                                                               \
+                                                                                    \
+    static void NAME##__unlink(NAME list, NAME##_node *node)                        \
+    {                                                                               \
+        if (node->prev)                                                             \
+            node->prev->next = node->next;                                          \
+        else                                                                        \
+            list->first = node->next;                                               \
+                                                                                    \
+        if (node->next)                                                             \
+            node->next->prev = node->prev;                                          \
+        else                                                                        \
+            list->last = node->prev;                                                \
+                                                                                    \
+        pak__pool_put(list->pool, node);                                            \
+    }                                                                               \
+                                                                                    \
+    /* The node holding element "*index", which becomes its index in that node */   \
+    static NAME##_node *NAME##__locate(NAME list, pak_size *index)                  \
+    {                                                                               \
+        NAME##_node *node = NULL;                                                   \
+        pak_size pos = *index;                                                      \
+                                                                                    \
+        if (pos <= list->count / 2) {                                               \
+            for (node = list->first; pos >= node->count; node = node->next)         \
+                pos -= node->count;                                                 \
+        } else {                                                                    \
+            pos = list->count - pos;                                                \
+            for (node = list->last; pos > node->count; node = node->prev)           \
+                pos -= node->count;                                                 \
+            pos = node->count - pos;                                                \
+        }                                                                           \
+                                                                                    \
+        *index = pos;                                                               \
+        return node;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_push(NAME list, TYPE data)                                \
+    {                                                                               \
+        NAME##_node *node = list->last;                                             \
+                                                                                    \
+        if (!node || node->count == PAK__ULIST_CAP(TYPE)) {                         \
+            node = NAME##__link(list, node);                                        \
+            pak_assert(node);                                                       \
+        }                                                                           \
+                                                                                    \
+        node->data[node->count++] = data;                                           \
+        list->count++;                                                              \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_unshift(NAME list, TYPE data)                             \
+    {                                                                               \
+        NAME##_node *node = list->first;                                            \
+        int i;                                                                      \
+                                                                                    \
+        if (!node || node->count == PAK__ULIST_CAP(TYPE)) {                         \
+            node = NAME##__link(list, NULL);                                        \
+            pak_assert(node);                                                       \
+        }                                                                           \
+                                                                                    \
+        for (i = node->count; i > 0; i--)                                           \
+            node->data[i] = node->data[i - 1];                                      \
+                                                                                    \
+        node->data[0] = data;                                                       \
+        node->count++;                                                              \
+        list->count++;                                                              \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX void NAME##_pop(NAME list)                                           \
+    {                                                                               \
+        NAME##_node *last = list->last;                                             \
+                                                                                    \
+        pak_assert(list->count > 0);                                                \
+                                                                                    \
+        FREE(last->data[last->count - 1]);                                          \
+        if (--last->count == 0)                                                     \
+            NAME##__unlink(list, last);                                             \
+                                                                                    \
+        list->count--;                                                              \
+                                                                                    \
+    fail:                                                                           \
+        return;                                                                     \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX void NAME##_shift(NAME list)                                         \
+    {                                                                               \
+        NAME##_node *first = list->first;                                           \
+        int i;                                                                      \
+                                                                                    \
+        pak_assert(list->count > 0);                                                \
+                                                                                    \
+        FREE(first->data[0]);                                                       \
+        first->count--;                                                             \
+                                                                                    \
+        for (i = 0; i < first->count; i++)                                          \
+            first->data[i] = first->data[i + 1];                                    \
+                                                                                    \
+        if (first->count == 0)                                                      \
+            NAME##__unlink(list, first);                                            \
+                                                                                    \
+        list->count--;                                                              \
+                                                                                    \
+    fail:                                                                           \
+        return;                                                                     \
+    }                                                                               \
+                                                                                    \
+    /* Takes negative indices like <name>_get of PAK Lists */                       \
+    PAK_PREFIX TYPE *NAME##_get(NAME list, pak_size index)                          \
+    {                                                                               \
+        NAME##_node *node = NULL;                                                   \
+                                                                                    \
+        if (index < 0)                                                              \
+            index += list->count;                                                   \
+                                                                                    \
+        pak_assert(0 <= index && index < list->count);                              \
+                                                                                    \
+        node = NAME##__locate(list, &index);                                        \
+        return &node->data[index];                                                  \
+                                                                                    \
+    fail:                                                                           \
+        return NULL;                                                                \
+    }                                                                               \
+                                                                                    \
+    /* Full nodes are split in half, so inserting in the middle is O(node size) */  \
+    PAK_PREFIX int NAME##_insert(NAME list, pak_size index, TYPE data)              \
+    {                                                                               \
+        NAME##_node *node = NULL;                                                   \
+        pak_size i;                                                                 \
+                                                                                    \
+        pak_assert(0 <= index && index <= list->count);                             \
+                                                                                    \
+        if (index == list->count)                                                   \
+            return NAME##_push(list, data);                                         \
+                                                                                    \
+        node = NAME##__locate(list, &index);                                        \
+                                                                                    \
+        if (node->count == PAK__ULIST_CAP(TYPE)) {                                  \
+            NAME##_node *next = NAME##__link(list, node);                           \
+            int half = node->count / 2;                                             \
+                                                                                    \
+            pak_assert(next);                                                       \
+                                                                                    \
+            for (i = half; i < node->count; i++)                                    \
+                next->data[i - half] = node->data[i];                               \
+                                                                                    \
+            next->count = node->count - half;                                       \
+            node->count = half;                                                     \
+                                                                                    \
+            if (index > half) {                                                     \
+                node = next;                                                        \
+                index -= half;                                                      \
+            }                                                                       \
+        }                                                                           \
+                                                                                    \
+        for (i = node->count; i > index; i--)                                       \
+            node->data[i] = node->data[i - 1];                                      \
+                                                                                    \
+        node->data[index] = data;                                                   \
+        node->count++;                                                              \
+        list->count++;                                                              \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    /* Nodes left less than half full are merged with the next one if it fits */    \
+    PAK_PREFIX int NAME##_erase(NAME list, pak_size index)                          \
+    {                                                                               \
+        NAME##_node *node = NULL;                                                   \
+        NAME##_node *next = NULL;                                                   \
+        pak_size i;                                                                 \
+                                                                                    \
+        if (index < 0)                                                              \
+            index += list->count;                                                   \
+                                                                                    \
+        pak_assert(0 <= index && index < list->count);                              \
+                                                                                    \
+        node = NAME##__locate(list, &index);                                        \
+        FREE(node->data[index]);                                                    \
+                                                                                    \
+        node->count--;                                                              \
+        for (i = index; i < node->count; i++)                                       \
+            node->data[i] = node->data[i + 1];                                      \
+                                                                                    \
+        list->count--;                                                              \
+                                                                                    \
+        if (node->count == 0) {                                                     \
+            NAME##__unlink(list, node);                                             \
+            return 0;                                                               \
+        }                                                                           \
+                                                                                    \
+        next = node->next;                                                          \
+        if (node->count < PAK__ULIST_CAP(TYPE) / 2 && next &&                       \
+                node->count + next->count <= PAK__ULIST_CAP(TYPE)) {                \
+            for (i = 0; i < next->count; i++)                                       \
+                node->data[node->count + i] = next->data[i];                        \
+                                                                                    \
+            node->count += next->count;                                             \
+            NAME##__unlink(list, next);                                             \
+        }                                                                           \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }
+
+/* Every element of an unrolled list, as "N->data[I]". "break" only leaves the inner loop */
+#define pak_ulist_foreach(L, N, I)\
+    for (N = (L)->first; N != NULL; N = N->next)\
+        for (I = 0; I < N->count; I++)
+
+/* Intrusive lists, see "Intrusive Lists" above */
+typedef struct pak_ilist_link {
+    struct pak_ilist_link *next;
+    struct pak_ilist_link *prev;
+} pak_ilist_link;
+
+/* The struct of type "T" whose member "M" is at "P" */
+#define pak_container_of(P, T, M) ((T *)(void *)((char *)(P) - offsetof(T, M)))
+
+#define PAK__INIT_ILIST_TYPE(NAME, STRUCT, MEMBER)                                  \
+    typedef struct {                                                                \
+        pak_ilist_link head; /* head.next is the first element, head.prev last */   \
+        pak_size count;                                                             \
+        const pak_allocator *alloc;                                                 \
+    } NAME##_;                                                                      \
+                                                                                    \
+    typedef NAME##_* NAME;                                                          \
+                                                                                    \
+    PAK_INLINE STRUCT *NAME##__elem(NAME list, pak_ilist_link *link)                \
+    {                                                                               \
+        if (link == &list->head)                                                    \
+            return NULL;                                                            \
+        return pak_container_of(link, STRUCT, MEMBER);                              \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE void NAME##__link(NAME list, pak_ilist_link *prev, STRUCT *elem)     \
+    {                                                                               \
+        pak_ilist_link *link = &elem->MEMBER;                                       \
+                                                                                    \
+        link->prev = prev;                                                          \
+        link->next = prev->next;                                                    \
+        prev->next->prev = link;                                                    \
+        prev->next = link;                                                          \
+        list->count++;                                                              \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE void NAME##_init(NAME list)                                          \
+    {                                                                               \
+        list->head.next = list->head.prev = &list->head;                            \
+        list->count = 0;                                                            \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE void NAME##_push(NAME list, STRUCT *elem)                            \
+    {                                                                               \
+        NAME##__link(list, list->head.prev, elem);                                  \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE void NAME##_unshift(NAME list, STRUCT *elem)                         \
+    {                                                                               \
+        NAME##__link(list, &list->head, elem);                                      \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE void NAME##_insert_after(NAME list, STRUCT *pos, STRUCT *elem)       \
+    {                                                                               \
+        NAME##__link(list, &pos->MEMBER, elem);                                     \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE void NAME##_insert_before(NAME list, STRUCT *pos, STRUCT *elem)      \
+    {                                                                               \
+        NAME##__link(list, pos->MEMBER.prev, elem);                                 \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE void NAME##_remove(NAME list, STRUCT *elem)                          \
+    {                                                                               \
+        pak_ilist_link *link = &elem->MEMBER;                                       \
+                                                                                    \
+        link->prev->next = link->next;                                              \
+        link->next->prev = link->prev;                                              \
+        link->next = link->prev = NULL;                                             \
+        list->count--;                                                              \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE int NAME##_linked(const STRUCT *elem)                                \
+    {                                                                               \
+        return elem->MEMBER.next != NULL;                                           \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE STRUCT *NAME##_first(NAME list)                                      \
+    {                                                                               \
+        return NAME##__elem(list, list->head.next);                                 \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE STRUCT *NAME##_last(NAME list)                                       \
+    {                                                                               \
+        return NAME##__elem(list, list->head.prev);                                 \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE STRUCT *NAME##_next(NAME list, STRUCT *elem)                         \
+    {                                                                               \
+        return NAME##__elem(list, elem->MEMBER.next);                               \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE STRUCT *NAME##_prev(NAME list, STRUCT *elem)                         \
+    {                                                                               \
+        return NAME##__elem(list, elem->MEMBER.prev);                               \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE STRUCT *NAME##_pop(NAME list)                                        \
+    {                                                                               \
+        STRUCT *elem = NAME##_last(list);                                           \
+                                                                                    \
+        if (elem)                                                                   \
+            NAME##_remove(list, elem);                                              \
+                                                                                    \
+        return elem;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_INLINE STRUCT *NAME##_shift(NAME list)                                      \
+    {                                                                               \
+        STRUCT *elem = NAME##_first(list);                                          \
+                                                                                    \
+        if (elem)                                                                   \
+            NAME##_remove(list, elem);                                              \
+                                                                                    \
+        return elem;                                                                \
+    }
+
+/* For header files */
+#define PAK_INIT_ILIST_PROTOTYPES(NAME, STRUCT, MEMBER)                             \
+    PAK__INIT_ILIST_TYPE(NAME, STRUCT, MEMBER)                                      \
+                                                                                    \
+    extern NAME NAME##_new(void);                                                   \
+    extern NAME NAME##_new_alloc(const pak_allocator *alloc);                       \
+    extern void NAME##_free(NAME *pp);
+
+#define PAK_INIT_ILIST(NAME, STRUCT, MEMBER)                                        \
+    PAK__INIT_ILIST_TYPE(NAME, STRUCT, MEMBER)                                      \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new_alloc(const pak_allocator *alloc)                    \
+    {                                                                               \
+        NAME list = (NAME)pak__alloc(alloc, sizeof(*list));                         \
+        pak_assert(list);                                                           \
+                                                                                    \
+        NAME##_init(list);                                                          \
+        list->alloc = alloc;                                                        \
+                                                                                    \
+        return list;                                                                \
+                                                                                    \
+    fail:                                                                           \
+        return NULL;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new(void)                                                \
+    {                                                                               \
+        return NAME##_new_alloc(NULL);                                              \
+    }                                                                               \
+                                                                                    \
+    /* The elements are only unlinked, they belong to the caller */                 \
+    PAK_PREFIX void NAME##_free(NAME *pp)                                           \
+    {                                                                               \
+        NAME list = *pp;                                                            \
+                                                                                    \
+        pak_assert(list); /* Double free? */                                        \
+                                                                                    \
+        while (list->count > 0)                                                     \
+            NAME##_shift(list);                                                     \
+                                                                                    \
+        pak__free(list->alloc, list);                                               \
+        *pp = NULL;                                                                 \
+                                                                                    \
+    fail:                                                                           \
+        return;                                                                     \
+    }
+
+/* Every element of an intrusive list, "E" may be unlinked from "L" inside the loop */
+#define pak_ilist_foreach(NAME, L, E, TMP)\
+    for (E = NAME##_first(L); E && (TMP = NAME##_next((L), E), 1); E = TMP)
 
 #endif /* PAK_NO_LIST */
 
@@ -643,27 +1831,236 @@ PAK_PREFIX float pak_math_rad_to_deg(float rad)
 
             typedef <type *> <name>;
 
-            int     <name>_count    (<name> arr);
-            int     <name>_max      (<name> arr);
-            size_t  <name>_elem_sz  (<name> arr);
-            int     <name>_isvalid  (<name> arr);
-            <name>  <name>_new      (int max);
-            void    <name>_free     (<name> *pp);
-            int     <name>_resize   (<name> *pp, int max);
-            int     <name>_expand   (<name> *pp);
-            int     <name>_contract (<name> *pp);
-            int     <name>_push     (<name> *pp, <type> val);
-            int     <name>_pop      (<name> *pp);
+            pak_size <name>_count    (<name> arr);
+            pak_size <name>_max      (<name> arr);
+            size_t   <name>_elem_sz  (<name> arr);
+            int      <name>_isvalid  (<name> arr);
+            <name>   <name>_new      (pak_size max);
+            <name>   <name>_new_alloc(pak_size max, const pak_allocator *alloc);
+            <name>   <name>_new_buf  (void *buf, size_t buf_sz);
+            <name>   <name>_map_file (const char *path, int flags);
+            void     <name>_free     (<name> *pp);
+            int      <name>_set_gc_range(<name> arr, pak__arr_gc_range gc_range);
+            int      <name>_resize   (<name> *pp, pak_size max);
+            int      <name>_expand   (<name> *pp);
+            int      <name>_contract (<name> *pp);
+            int      <name>_reserve  (<name> *pp, pak_size max);
+            int      <name>_shrink_to_fit(<name> *pp);
+            int      <name>_push     (<name> *pp, <type> val);
+            int      <name>_pop      (<name> *pp);
+            <type>  *<name>_back     (<name> arr);
+            int      <name>_push_n   (<name> *pp, const <type> *vals, pak_size n);
+            int      <name>_extend   (<name> *pp, <name> src);
+            int      <name>_insert_range(<name> *pp, pak_size index, const <type> *vals, pak_size n);
+            int      <name>_erase_range (<name> *pp, pak_size index, pak_size n);
+            int      <name>_insert_at(<name> *pp, pak_size index, <type> val);
+            int      <name>_erase_at (<name> *pp, pak_size index);
+            int      <name>_swap_remove(<name> *pp, pak_size index);
 
         Notice PAK Arrays do not have getter or setter functions.
         That is because you can index the array with "[]".
 
+        "<name>_push", "<name>_pop" and "<name>_back" are defined "static inline"
+        (also by PAK_INIT_ARR_PROTOTYPES), so a push which does not need to resize
+        is a capacity check and a store with no call, much like a push written
+        by hand. Unlike a plain loop of stores it can not be vectorized, since
+        the count lives in memory. Define PAK_ARR_UNCHECKED before including this
+        file to compile out the signature and element size checks in release
+        builds.
+
+    Garbage Collection:
+
+        The third argument of PAK_INIT_ARR is called on every element removed
+        from the array, by pops, erases, shrinking resizes and frees. For large
+        arrays the call per element adds up, so a range destructor can be set
+        which gets every contiguous block of removed elements in one call:
+
+            void free_all(void *first, size_t n)
+            {
+                char **s = first;
+                while (n--)
+                    free(*s++);
+            }
+
+            str_array_set_gc_range(arr, free_all);
+
+        When set it replaces the per element one, which stays the fallback.
+
+    Growth Policies:
+
+        By default an array grows by its initial max every time it fills up,
+        which keeps memory tight but makes pushing N elements cost O(N^2) copies.
+        PAK_INIT_ARR_EX takes a fourth argument which picks a different policy:
+
+            PAK_INIT_ARR_EX(int_array, int, NULL, pak_arr_growth_mul(2.0f))
+
+        The available policies are:
+
+            pak_arr_growth_add()    // Grow by the initial max (default)
+            pak_arr_growth_mul(F)   // Multiply max by F, amortized O(1) pushes
+            pak_arr_growth_func(FN) // Call "pak_size FN(pak_size max, pak_size need)" for the new max
+
+        The raw functions take the policy through pak_arr_new_growth, and it can
+        be swapped out later on with pak_arr_set_growth.
+
+    Shrinking:
+
+        Popping only shrinks an array once less than a quarter of it is in use
+        (see PAK_ARR_SHRINK_RATIO), and then only down to about half full. Arrays
+        never shrink on their own below their initial max, or below the size
+        given to "<name>_reserve", so a loop which reserves up front never reallocs.
+        "<name>_shrink_to_fit" trims the array down to its count and lowers that
+        floor back down.
+
+    Alignment:
+
+        The last argument of PAK_INIT_ARR_EX_ALIGNED (or of pak_arr_new_aligned) is a
+        power of two which "arr[0]" will always be aligned to, even after resizes.
+        This allows for aligned SIMD loads, and with 64 bytes the elements never share
+        a cache line with the array header:
+
+            PAK_INIT_ARR_EX_ALIGNED(simd_array, float, NULL, pak_arr_growth_mul(2.0f), 32)
+            float *arr = pak_arr_new_aligned(float, 1024, 64);
+
+    Sorting:
+
+        "pak_arr_sort" is a plain qsort. For speed, PAK_INIT_ARR_SORT generates a
+        "<name>_sort" introsort where the comparator is inlined, "LESS(a, b)" must
+        be a macro or function returning true when "a" goes before "b":
+
+            #define point_less(A, B) ((A).x < (B).x)
+            PAK_INIT_ARR_SORT(point_array, point, point_less)
+
+        pak_iarr, pak_larr, pak_farr and pak_darr already have "<name>_sort", as
+        well as an LSD radix sort, "<name>_radix_sort", which is usually faster
+        on large arrays but allocates a temporary buffer twice the array's size.
+
+        Large arrays can also be sorted on several threads with
+        "pak_arr_parallel_sort(arr, cmp, threads)", which takes a qsort comparator.
+        Every thread sorts a chunk, and the chunks are then merged together in
+        parallel through a single scratch array. Define PAK_NO_THREADS to build
+        without pthreads, the sort then runs on the calling thread.
+
+    Searching:
+
+        PAK_INIT_ARR_SEARCH, given the same "LESS" as the array was sorted with,
+        generates typed binary searches with the comparator inlined:
+
+            PAK_INIT_ARR_SEARCH(point_array, point, point_less)
+
+            pak_size i = point_array_lower_bound(arr, key);  // first not less than key
+            pak_size j = point_array_upper_bound(arr, key);  // first greater than key
+            pak_size n = point_array_equal_range(arr, key, &i, &j);
+            if (point_array_contains(arr, key)) ...
+
+        "<name>_lower_bound_branchless" returns the same as lower_bound, but its
+        loop has no unpredictable branches, which pays off on small to medium
+        arrays. For large arrays searched many times, "<name>_eytzinger" copies a
+        sorted array to a new one in Eytzinger (breadth first) order, which keeps
+        the first levels of the search on a few cache lines and lets the next
+        levels be prefetched. "<name>_eytzinger_lower_bound" searches that copy and
+        returns an index into it, or -1 if every element is less than the key.
+
+        pak_iarr, pak_larr, pak_farr and pak_darr already have these functions.
+
+    Inline Buffers:
+
+        Small, short lived arrays can skip the heap entirely by living in a buffer
+        declared with PAK_ARR_BUF, usually on the stack. They are indexed and pushed
+        to like any other array, and the first time they need more room than the
+        buffer has they are transparently moved over to the heap:
+
+            PAK_ARR_BUF(buf, int, 32);
+            int_array arr = int_array_new_buf(&buf, sizeof(buf));
+            // or: int *arr = pak_arr_new_buf(int, buf);
+
+        "<name>_free" must still be called, it only free's the heap copy if there
+        is one, and inline arrays never shrink below the size of their buffer.
+        Arrays declared with an alignment skip ahead in the buffer to keep their
+        first element aligned, so they fit fewer elements than it was declared for
+        unless the buffer itself is aligned, and keep the alignment on the heap.
+
+    Struct of Arrays:
+
+        Tables of structs where hot loops only read a field or two waste most of
+        every cache line they fetch. PAK_INIT_SOA instead keeps one contiguous
+        column per field, each a PAK Array aligned to PAK_SOA_ALIGN (64 bytes by
+        default), with a single count and max shared between them. Fields are
+        given as up to 16 "(type, field)" pairs:
+
+            PAK_INIT_SOA(particles, (float, x), (float, y), (int, id))
+
+            <name>   <name>_new        (pak_size max);
+            <name>   <name>_new_alloc  (pak_size max, const pak_allocator *alloc);
+            void     <name>_free       (<name> *pp);
+            pak_size <name>_count      (<name> soa);
+            pak_size <name>_max        (<name> soa);
+            int      <name>_reserve    (<name> soa, pak_size max);
+            int      <name>_push       (<name> soa, <type1> field1, <type2> field2, ...);
+            int      <name>_pop        (<name> soa);
+            int      <name>_swap_remove(<name> soa, pak_size index);
+            <type>  *<name>_col_<field>(<name> soa);
+
+        Every column is also a member named after its field, so a loop over one
+        of them is a plain, vectorizable loop over an array:
+
+            float *x = p->x, *y = p->y;
+            for (i = 0; i < particles_count(p); i++)
+                x[i] += y[i];
+
+        Rows are only appended and removed through the functions above, the
+        columns' own PAK Array counts are not kept up to date.
+
+    Mapped Files:
+
+        "<name>_map_file" maps an array straight out of a file written by an
+        earlier one, so loading it costs nothing until its pages are touched.
+        The array header lives at the start of the file, and "[]" and
+        "<name>_count" work as usual:
+
+            pak_farr arr = pak_farr_map_file("weights.bin", PAK_ARR_MAP_READ);
+
+        With PAK_ARR_MAP_READ changes stay private to the process and the array
+        can not grow. With PAK_ARR_MAP_WRITE changes go back to the file, which
+        grows geometrically through ftruncate and mremap (a fresh mmap where
+        mremap is missing). Add PAK_ARR_MAP_CREATE to start a new file. Mapped
+        arrays never garbage collect, "<name>_free" unmaps them. The format is
+        the in memory one, so files only move between builds of the same
+        architecture. Mapping needs POSIX, so with a strict "-std=c99" define
+        _POSIX_C_SOURCE to 200809L before any include. Define PAK_NO_MMAP to
+        build without it, "_map_file" then always fails.
+
+    Statistics:
+
+        Define PAK_ARR_STATS (in every file which includes this one, it changes
+        the array header) to count what the arrays of a program are doing:
+        pushes, pops, resizes, the bytes resizes copied and the peak count and
+        max. Every array keeps its own counters, and they are also summed up per
+        line of code which created arrays and for the whole program:
+
+            pak_arr_stats s = pak_arr_stats_of(arr);   // this array only
+            pak_arr_stats t = pak_arr_stats_get();     // every array
+            pak_arr_stats_dump(stderr);                // one line per call site
+            pak_arr_stats_reset();
+
+        Arrays made with the pak_arr_new macros or the constructors of the common
+        types (pak_iarr, pak_sarr...) are listed under the line calling them. A
+        function can not know its caller's line, so arrays of your own types are
+        listed under their PAK_INIT_ARR line, unless their constructors are
+        wrapped with pak_arr_stats_site after it (or after the prototypes):
+
+            #define int_array_new(M) ((int_array) pak_arr_stats_site(int_array_new(M)))
+
+        A site with many resizes and a lot copied usually wants a "_reserve" or a
+        larger initial max. The counters are not thread safe, and mapped files are
+        not interchangeable between builds with and without them.
+
     Example:
 
         int *arr = pak_arr_new(int, 1024);
         assert(arr);
 
-        int i;
+        pak_size i;
         for (i = 0; i < 1024; i++)
             pak_arr_push(&arr, i);
 
@@ -676,19 +2073,101 @@ PAK_PREFIX float pak_math_rad_to_deg(float rad)
 /* Function pointer to a free elements when doing resizes, pops, etc */
 typedef void (*pak__arr_gc)(void *);
 
+/* Optional batch version of the above, called once per contiguous block of "n" elements */
+typedef void (*pak__arr_gc_range)(void *first, size_t n);
+
+/* Arrays only shrink automatically once less than 1/PAK_ARR_SHRINK_RATIO of them is in use */
+#ifndef PAK_ARR_SHRINK_RATIO
+#   define PAK_ARR_SHRINK_RATIO 4
+#endif
+
+/* Signature and element size checks, which can be compiled out with PAK_ARR_UNCHECKED.
+   The "if (0)" keeps the fail label referenced so there are no warnings. */
+#ifdef PAK_ARR_UNCHECKED
+#   define pak_arr_check(C) if (0) goto fail;
+#else
+#   define pak_arr_check(C) pak_assert(C)
+#endif
+
+/* Flags kept inside of the array metadata */
+#define PAK_ARR_INLINE 0x1 /* Storage belongs to the caller, see pak_arr_new_buf */
+#define PAK_ARR_MAPPED 0x2 /* Storage is a mapped file, see pak_arr_map_file */
+#define PAK_ARR_SHARED 0x4 /* Changes to a mapped array are written to the file */
+
+/* Flags for pak_arr_map_file */
+#define PAK_ARR_MAP_READ   0x0 /* Changes stay private to the process, and it can not grow */
+#define PAK_ARR_MAP_WRITE  0x1 /* Changes and growth are written back to the file */
+#define PAK_ARR_MAP_CREATE 0x2 /* Create the file, or empty it, requires PAK_ARR_MAP_WRITE */
+
+/* File mapping uses mmap where available, define PAK_NO_MMAP to build without it */
+#if !defined(PAK_NO_MMAP) && defined(PAK__POSIX)
+#   define PAK__ARR_MMAP
+#endif
+
 /* A unique signature kept inside of the array metadata */
 #ifndef PAK_ARR_SIGNATURE
 #   define PAK_ARR_SIGNATURE 0x5F3C2A
 #endif
 
+/* Function pointer used by PAK_ARR_GROW_FUNC, returns a new max of at least "need" */
+typedef pak_size (*pak__arr_grow)(pak_size max, pak_size need);
+
+/* Policies describing how an array grows once it runs out of room */
+typedef enum {
+    PAK_ARR_GROW_ADD  = 0, /* Grow by the initial max (default) */
+    PAK_ARR_GROW_MUL  = 1, /* Grow geometrically by a factor */
+    PAK_ARR_GROW_FUNC = 2  /* Ask a callback for the new max */
+} pak_arr_growth_policy;
+
+typedef struct {
+    pak_arr_growth_policy policy;
+    float factor;
+    pak__arr_grow fn;
+} pak_arr_growth;
+
+#ifdef PAK_ARR_STATS
+#   include <stdio.h> /* pak_arr_stats_dump */
+
+/* Counters kept for every array, every call site and all arrays together */
+typedef struct {
+    unsigned long arrays;  /* Arrays created */
+    unsigned long resizes; /* Times the storage was reallocated */
+    size_t copied;         /* Bytes those reallocations copied */
+    unsigned long pushes;  /* Elements added by pushes, inserts and extends */
+    unsigned long pops;    /* Elements removed by pops, erases and swap removes */
+    pak_size peak_count;   /* Highest count */
+    pak_size peak_max;     /* Highest capacity */
+} pak_arr_stats;
+
+/* Internal, the counters of every array created on one line */
+typedef struct pak__arr_site {
+    const char *file;
+    int line;
+    pak_arr_stats stats;
+    struct pak__arr_site *next;
+} pak__arr_site;
+#endif
+
 /* Header which contains the array metadata */
 typedef struct {
-    int count;
-    int max;
-    int rate;
+    pak_size count;
+    pak_size max;
+    pak_size min;
+    pak_size rate;
+    pak_arr_growth growth;
     size_t elem_sz;
+    size_t align;
+    size_t pad;
     unsigned int sig;
+    unsigned int flags;
+    int fd;
     pak__arr_gc gc;
+    pak__arr_gc_range gc_range;
+    const pak_allocator *alloc;
+#ifdef PAK_ARR_STATS
+    pak_arr_stats stats;
+    pak__arr_site *site; /* NULL when not created through a macro which tags it */
+#endif
 } pak__arr;
 
 /* The header is always the first element at the array, but we increment the
@@ -704,20 +2183,102 @@ typedef struct {
 #define pak_arr_last(V)         V[pak_arr_count(V) - 1]
 #define pak_arr_sort(V, CMP)    qsort((void *) (V), pak_arr_count(V), pak_arr_elem_sz(V), CMP);
 
+/* Instrumentation, see "Statistics" above. PAK__ARR_SITE tags an array with the line
+   which created it, and PAK__ARR_NOTE counts what just happened to it */
+#ifdef PAK_ARR_STATS
+PAK_PREFIX pak_arr_stats pak_arr_stats_get(void);
+PAK_PREFIX void pak_arr_stats_dump(FILE *f);
+PAK_PREFIX void pak_arr_stats_reset(void);
+#define pak_arr_stats_of(V) (pak_arr_header((V))->stats)
+
+PAK_PREFIX void *pak__arr_stats_site(void *arr, const char *file, int line);
+PAK_PREFIX void pak__arr_stats_init(pak__arr *head);
+PAK_PREFIX void pak__arr_stats_note(pak__arr *head, unsigned long pushes, unsigned long pops,
+                                    unsigned long resizes, size_t copied);
+#   define PAK__ARR_SITE(A) pak__arr_stats_site((A), __FILE__, __LINE__)
+#   define PAK__ARR_STATS_INIT(H) pak__arr_stats_init(H)
+#   define PAK__ARR_NOTE(H, PUSHES, POPS, RESIZES, COPIED)\
+        pak__arr_stats_note((H), (PUSHES), (POPS), (RESIZES), (COPIED))
+#else
+#   define PAK__ARR_SITE(A) (A)
+#   define PAK__ARR_STATS_INIT(H) ((void)0)
+#   define PAK__ARR_NOTE(H, PUSHES, POPS, RESIZES, COPIED) ((void)0)
+#endif
+
+/* Lists a new array under the line calling this, for wrapping typed constructors */
+#define pak_arr_stats_site(V) PAK__ARR_SITE(V)
+
 /* Get values from the array , without knowing the type, for internal use */
 #define pak_arr_notype_get(V, I)    (void *)((char *) (V) + ((I) * pak_arr_elem_sz(V)))
 #define pak_arr_notype_last(V)      pak_arr_notype_get((V), pak_arr_count(V) - 1)
 
-PAK_PREFIX void *pak__arr_new(size_t sz, int max);
-#define pak_arr_new(T, M) (T *) pak__arr_new(sizeof(T), (M))
+PAK_PREFIX void *pak__arr_new(size_t sz, pak_size max);
+#define pak_arr_new(T, M) (T *) PAK__ARR_SITE(pak__arr_new(sizeof(T), (M)))
+
+PAK_PREFIX void *pak__arr_new_gc(size_t sz, pak_size max, pak__arr_gc gc);
+#define pak_arr_new_gc(T, M, F) (T *) PAK__ARR_SITE(pak__arr_new_gc(sizeof(T), (M), (F)))
+
+PAK_PREFIX void *pak__arr_new_growth(size_t sz, pak_size max, pak__arr_gc gc, pak_arr_growth growth);
+#define pak_arr_new_growth(T, M, F, G)\
+    (T *) PAK__ARR_SITE(pak__arr_new_growth(sizeof(T), (M), (F), (G)))
+
+/* "A" must be a power of two, "arr[0]" will always sit on an "A" byte boundary */
+PAK_PREFIX void *pak__arr_new_aligned(size_t sz, pak_size max, size_t align);
+#define pak_arr_new_aligned(T, M, A) (T *) PAK__ARR_SITE(pak__arr_new_aligned(sizeof(T), (M), (A)))
+
+/* "A" is a "const pak_allocator *", NULL for pak_malloc */
+PAK_PREFIX void *pak__arr_new_alloc(size_t sz, pak_size max, const pak_allocator *alloc);
+#define pak_arr_new_alloc(T, M, A) (T *) PAK__ARR_SITE(pak__arr_new_alloc(sizeof(T), (M), (A)))
+
+PAK_PREFIX void *pak__arr_new_ex(size_t sz, pak_size max, pak__arr_gc gc, pak_arr_growth growth,
+                                 size_t align, const pak_allocator *alloc);
+#define pak_arr_new_ex(T, M, F, G, A, AL)\
+    (T *) PAK__ARR_SITE(pak__arr_new_ex(sizeof(T), (M), (F), (G), (A), (AL)))
+
+/* Declares a buffer "B" which can hold the header and "M" elements of type "T" */
+#define PAK_ARR_BUF(B, T, M) \
+    union { pak__arr head; char bytes[sizeof(pak__arr) + sizeof(T) * (M)]; } B
+
+/* Creates an array inside of a buffer declared with PAK_ARR_BUF, skipping ahead in the buffer
+   as needed to align the first element to "align" (0 for no alignment) */
+PAK_PREFIX void *pak__arr_new_buf(size_t sz, void *buf, size_t buf_sz, size_t align);
+#define pak_arr_new_buf(T, B)\
+    (T *) PAK__ARR_SITE(pak__arr_new_buf(sizeof(T), (void *) &(B), sizeof(B), 0))
+
+/* Maps an array kept in a file, flags are a combination of PAK_ARR_MAP_* */
+PAK_PREFIX void *pak__arr_map_file(const char *path, size_t sz, int flags);
+#define pak_arr_map_file(T, P, F) (T *) PAK__ARR_SITE(pak__arr_map_file((P), sizeof(T), (F)))
+
+/* Internal, moves an inline array over to the heap */
+PAK_PREFIX int pak__arr_spill(void **pp, pak_size max);
+
+/* Internal, allocation size and header offset for aligned arrays */
+PAK_PREFIX size_t pak__arr_alloc_sz(size_t sz, pak_size max, size_t align);
+PAK_PREFIX size_t pak__arr_pad(void *base, size_t align);
+#define pak__arr_base(H) ((void *)((char *)(H) - (H)->pad))
+
+/* Growth policy constructors */
+PAK_PREFIX pak_arr_growth pak_arr_growth_add(void);
+PAK_PREFIX pak_arr_growth pak_arr_growth_mul(float factor);
+PAK_PREFIX pak_arr_growth pak_arr_growth_func(pak__arr_grow fn);
+
+PAK_PREFIX int pak__arr_set_growth(void *arr, pak_arr_growth growth);
+#define pak_arr_set_growth(V, G) pak__arr_set_growth((void *) (V), (G))
 
-PAK_PREFIX void *pak__arr_new_gc(size_t sz, int max, pak__arr_gc gc);
-#define pak_arr_new_gc(T, M, F) (T *) pak__arr_new_gc(sizeof(T), (M), (F))
+/* Destroys removed elements a block at a time instead of calling the gc for each one */
+PAK_PREFIX int pak__arr_set_gc_range(void *arr, pak__arr_gc_range gc_range);
+#define pak_arr_set_gc_range(V, F) pak__arr_set_gc_range((void *) (V), (F))
+
+PAK_PREFIX int pak__arr_reserve(void **pp, pak_size max);
+#define pak_arr_reserve(PP, M) pak__arr_reserve((void **) (PP), (M))
+
+PAK_PREFIX int pak__arr_shrink_to_fit(void **pp);
+#define pak_arr_shrink_to_fit(PP) pak__arr_shrink_to_fit((void **) (PP))
 
 PAK_PREFIX void pak__arr_free(void **pp);
 #define pak_arr_free(PP) pak__arr_free((void **) (PP))
 
-PAK_PREFIX int pak__arr_resize(void **pp, int max);
+PAK_PREFIX int pak__arr_resize(void **pp, pak_size max);
 #define pak_arr_resize(PP, M) pak__arr_resize((void **) (PP), (M))
 
 PAK_PREFIX int pak__arr_expand(void **pp);
@@ -732,145 +2293,2664 @@ PAK_PREFIX int pak__arr_push(void **pp, size_t sz, void *e);
 PAK_PREFIX int pak__arr_pop(void **pp);
 #define pak_arr_pop(PP) pak__arr_pop((void **) (PP))
 
+/* Bulk operations, "E" points to "N" elements which must not live inside of the array
+   itself (with the exception of pak_arr_push_n and pak_arr_extend) */
+PAK_PREFIX int pak__arr_push_n(void **pp, size_t sz, const void *e, pak_size n);
+#define pak_arr_push_n(PP, E, N) pak__arr_push_n((void **) (PP), sizeof(*(E)), (const void *) (E), (N))
+
+PAK_PREFIX int pak__arr_extend(void **pp, const void *src);
+#define pak_arr_extend(PP, V) pak__arr_extend((void **) (PP), (const void *) (V))
+
+PAK_PREFIX int pak__arr_insert_range(void **pp, pak_size index, size_t sz, const void *e, pak_size n);
+#define pak_arr_insert_range(PP, I, E, N)\
+    pak__arr_insert_range((void **) (PP), (I), sizeof(*(E)), (const void *) (E), (N))
+
+PAK_PREFIX int pak__arr_erase_range(void **pp, pak_size index, pak_size n);
+#define pak_arr_erase_range(PP, I, N) pak__arr_erase_range((void **) (PP), (I), (N))
+
+/* Single element versions, which shift the tail over with one memmove */
+#define pak_arr_insert_at(PP, I, E)\
+    pak__arr_insert_range((void **) (PP), (I), sizeof(E), (const void *) &(E), 1)
+#define pak_arr_erase_at(PP, I) pak__arr_erase_range((void **) (PP), (I), 1)
+
+/* Removes an element in O(1) by moving the last one into its place, which breaks order */
+PAK_PREFIX int pak__arr_swap_remove(void **pp, pak_size index);
+#define pak_arr_swap_remove(PP, I) pak__arr_swap_remove((void **) (PP), (I))
+
+/* Internal, grows the array so it can hold "need" elements */
+PAK_PREFIX int pak__arr_grow_to(void **pp, pak_size need);
+
+/* Internal, shrinks the array after a removal if it fell below PAK_ARR_SHRINK_RATIO */
+PAK_PREFIX void pak__arr_settle(void **pp);
+
+/* Internal, garbage collects "n" elements from "first" with gc_range, or else gc */
+PAK_PREFIX void pak__arr_destroy(void *arr, pak_size first, pak_size n);
+
+/* Internal, resizes and releases mapped arrays */
+PAK_PREFIX int pak__arr_remap(void **pp, pak_size max);
+PAK_PREFIX void pak__arr_unmap(pak__arr *head);
+
+/* Typed push, pop and back, these are inlined into every file so that pushing is
+   a check and a store through "TYPE *", only going out of line when the array is full */
+#define PAK__INIT_ARR_INLINE(NAME, TYPE)                                                            \
+    PAK_INLINE int NAME##_push(NAME *pp, TYPE val)                                                  \
+    {                                                                                               \
+        pak__arr *head = pak_arr_header(*pp);                                                       \
+        pak_arr_check(head->sig == PAK_ARR_SIGNATURE);                                              \
+        pak_arr_check(head->elem_sz == sizeof(TYPE));                                               \
+                                                                                                    \
+        if (head->count >= head->max) {                                                             \
+            pak_assert(pak__arr_grow_to((void **) pp, head->count + 1) == 0);                       \
+            head = pak_arr_header(*pp);                                                             \
+        }                                                                                           \
+                                                                                                    \
+        (*pp)[head->count++] = val;                                                                 \
+        PAK__ARR_NOTE(head, 1, 0, 0, 0);                                                            \
+        return 0;                                                                                   \
+                                                                                                    \
+    fail:                                                                                           \
+        return -1;                                                                                  \
+    }                                                                                               \
+                                                                                                    \
+    PAK_INLINE int NAME##_pop(NAME *pp)                                                             \
+    {                                                                                               \
+        pak__arr *head = pak_arr_header(*pp);                                                       \
+        pak_arr_check(head->sig == PAK_ARR_SIGNATURE);                                              \
+                                                                                                    \
+        if (head->count > 0) {                                                                      \
+            if (head->gc || head->gc_range)                                                         \
+                pak__arr_destroy(*pp, head->count - 1, 1);                                          \
+                                                                                                    \
+            head->count--;                                                                          \
+            PAK__ARR_NOTE(head, 0, 1, 0, 0);                                                        \
+                                                                                                    \
+            if (head->count < head->max / PAK_ARR_SHRINK_RATIO)                                     \
+                pak__arr_settle((void **) pp);                                                      \
+        }                                                                                           \
+                                                                                                    \
+        return 0;                                                                                   \
+                                                                                                    \
+    fail:                                                                                           \
+        return -1;                                                                                  \
+    }                                                                                               \
+                                                                                                    \
+    PAK_INLINE TYPE *NAME##_back(NAME arr)                                                          \
+    {                                                                                               \
+        return (pak_arr_count(arr) > 0) ? &arr[pak_arr_count(arr) - 1] : NULL;                      \
+    }
+
 /* Create typesafe wrapper functions for the array implementation */
-#define PAK_INIT_ARR(NAME, TYPE, GC)                                                                \
+#define PAK_INIT_ARR(NAME, TYPE, GC) \
+    PAK_INIT_ARR_EX(NAME, TYPE, GC, pak_arr_growth_add())
+
+/* Same as PAK_INIT_ARR, but with a growth policy (e.g. "pak_arr_growth_mul(2)") */
+#define PAK_INIT_ARR_EX(NAME, TYPE, GC, GROWTH) \
+    PAK_INIT_ARR_EX_ALIGNED(NAME, TYPE, GC, GROWTH, 0)
+
+/* Same as PAK_INIT_ARR_EX, but with an alignment for the first element (0 for no alignment) */
+#define PAK_INIT_ARR_EX_ALIGNED(NAME, TYPE, GC, GROWTH, ALIGN)                                      \
     typedef TYPE* NAME;                                                                             \
                                                                                                     \
-    PAK_PREFIX int NAME##_count(NAME arr)           { return pak_arr_count(arr); }                  \
-    PAK_PREFIX int NAME##_max(NAME arr)             { return pak_arr_max(arr); }                    \
+    PAK__INIT_ARR_INLINE(NAME, TYPE)                                                                \
+                                                                                                    \
+    PAK_PREFIX pak_size NAME##_count(NAME arr)      { return pak_arr_count(arr); }                  \
+    PAK_PREFIX pak_size NAME##_max(NAME arr)        { return pak_arr_max(arr); }                    \
     PAK_PREFIX size_t NAME##_elem_sz(NAME arr)      { return pak_arr_elem_sz(arr); }                \
     PAK_PREFIX int NAME##_isvalid(NAME arr)         { return pak_arr_isvalid(arr); }                \
-    PAK_PREFIX NAME NAME##_new(int max)             { return pak_arr_new_gc(TYPE, max, GC); }       \
+    PAK_PREFIX NAME NAME##_new(pak_size max)                                                        \
+        { return pak_arr_new_ex(TYPE, max, GC, GROWTH, ALIGN, NULL); }                              \
+    PAK_PREFIX NAME NAME##_new_alloc(pak_size max, const pak_allocator *alloc)                      \
+        { return pak_arr_new_ex(TYPE, max, GC, GROWTH, ALIGN, alloc); }                             \
+    PAK_PREFIX NAME NAME##_new_buf(void *buf, size_t buf_sz)                                        \
+        {                                                                                           \
+            NAME arr = (NAME)PAK__ARR_SITE(pak__arr_new_buf(sizeof(TYPE), buf, buf_sz, ALIGN));     \
+            if (arr) {                                                                              \
+                pak_arr_header(arr)->gc = GC;                                                       \
+                pak_arr_set_growth(arr, GROWTH);                                                    \
+            }                                                                                       \
+            return arr;                                                                             \
+        }                                                                                           \
+    PAK_PREFIX NAME NAME##_map_file(const char *path, int flags)                                    \
+        { return (NAME)PAK__ARR_SITE(pak__arr_map_file(path, sizeof(TYPE), flags)); }               \
     PAK_PREFIX void NAME##_free(NAME *pp)           { pak_arr_free(pp); }                           \
-    PAK_PREFIX int NAME##_resize(NAME *pp, int max) { return pak_arr_resize(pp, max); }             \
+    PAK_PREFIX int NAME##_set_gc_range(NAME arr, pak__arr_gc_range gc_range)                        \
+        { return pak_arr_set_gc_range(arr, gc_range); }                                             \
+    PAK_PREFIX int NAME##_resize(NAME *pp, pak_size max)                                            \
+        { return pak_arr_resize(pp, max); }                                                         \
     PAK_PREFIX int NAME##_expand(NAME *pp)          { return pak_arr_expand(pp); }                  \
     PAK_PREFIX int NAME##_contract(NAME *pp)        { return pak_arr_contract(pp); }                \
-    PAK_PREFIX int NAME##_push(NAME *pp, TYPE val)  { return pak_arr_push(pp, val); }               \
-    PAK_PREFIX int NAME##_pop(NAME *pp)             { return pak_arr_pop(pp); }
+    PAK_PREFIX int NAME##_reserve(NAME *pp, pak_size max)                                           \
+        { return pak_arr_reserve(pp, max); }                                                        \
+    PAK_PREFIX int NAME##_shrink_to_fit(NAME *pp)   { return pak_arr_shrink_to_fit(pp); }           \
+    PAK_PREFIX int NAME##_push_n(NAME *pp, const TYPE *vals, pak_size n)                            \
+        { return pak_arr_push_n(pp, vals, n); }                                                     \
+    PAK_PREFIX int NAME##_extend(NAME *pp, NAME src)                                                \
+        { return pak_arr_extend(pp, src); }                                                         \
+    PAK_PREFIX int NAME##_insert_range(NAME *pp, pak_size index, const TYPE *vals, pak_size n)      \
+        { return pak_arr_insert_range(pp, index, vals, n); }                                        \
+    PAK_PREFIX int NAME##_erase_range(NAME *pp, pak_size index, pak_size n)                         \
+        { return pak_arr_erase_range(pp, index, n); }                                               \
+    PAK_PREFIX int NAME##_insert_at(NAME *pp, pak_size index, TYPE val)                             \
+        { return pak_arr_insert_at(pp, index, val); }                                               \
+    PAK_PREFIX int NAME##_erase_at(NAME *pp, pak_size index)                                        \
+        { return pak_arr_erase_at(pp, index); }                                                     \
+    PAK_PREFIX int NAME##_swap_remove(NAME *pp, pak_size index)                                     \
+        { return pak_arr_swap_remove(pp, index); }
 
 /* For header files */
-#define PAK_INIT_ARR_PROTOTYPES(NAME, TYPE)         \
-    typedef TYPE* NAME;                             \
-                                                    \
-    extern int NAME##_count(NAME arr);              \
-    extern int NAME##_max(NAME arr);                \
-    extern size_t NAME##_elem_sz(NAME arr);         \
-    extern int NAME##_isvalid(NAME arr);            \
-    extern NAME NAME##_new(int max);                \
-    extern void NAME##_free(NAME *pp);              \
-    extern int NAME##_resize(NAME *pp, int max);    \
-    extern int NAME##_expand(NAME *pp);             \
-    extern int NAME##_contract(NAME *pp);           \
-    extern int NAME##_push(NAME *pp, TYPE val);     \
-    extern int NAME##_pop(NAME *pp);
+#define PAK_INIT_ARR_PROTOTYPES(NAME, TYPE)                                                         \
+    typedef TYPE* NAME;                                                                             \
+                                                                                                    \
+    PAK__INIT_ARR_INLINE(NAME, TYPE)                                                                \
+                                                                                                    \
+    extern pak_size NAME##_count(NAME arr);                                                         \
+    extern pak_size NAME##_max(NAME arr);                                                           \
+    extern size_t NAME##_elem_sz(NAME arr);                                                         \
+    extern int NAME##_isvalid(NAME arr);                                                            \
+    extern NAME NAME##_new(pak_size max);                                                           \
+    extern NAME NAME##_new_alloc(pak_size max, const pak_allocator *alloc);                         \
+    extern NAME NAME##_new_buf(void *buf, size_t buf_sz);                                           \
+    extern NAME NAME##_map_file(const char *path, int flags);                                       \
+    extern void NAME##_free(NAME *pp);                                                              \
+    extern int NAME##_set_gc_range(NAME arr, pak__arr_gc_range gc_range);                           \
+    extern int NAME##_resize(NAME *pp, pak_size max);                                               \
+    extern int NAME##_expand(NAME *pp);                                                             \
+    extern int NAME##_contract(NAME *pp);                                                           \
+    extern int NAME##_reserve(NAME *pp, pak_size max);                                              \
+    extern int NAME##_shrink_to_fit(NAME *pp);                                                      \
+    extern int NAME##_push_n(NAME *pp, const TYPE *vals, pak_size n);                               \
+    extern int NAME##_extend(NAME *pp, NAME src);                                                   \
+    extern int NAME##_insert_range(NAME *pp, pak_size index, const TYPE *vals, pak_size n);         \
+    extern int NAME##_erase_range(NAME *pp, pak_size index, pak_size n);                            \
+    extern int NAME##_insert_at(NAME *pp, pak_size index, TYPE val);                                \
+    extern int NAME##_erase_at(NAME *pp, pak_size index);                                           \
+    extern int NAME##_swap_remove(NAME *pp, pak_size index);
+
+/* Partitions this small or smaller are insertion sorted */
+#ifndef PAK_ARR_SORT_CUTOFF
+#   define PAK_ARR_SORT_CUTOFF 16
+#endif
 
-/* Define commmon types for PAK arr */
-#ifdef PAK_IMPLEMENTATION
-    PAK_INIT_ARR(pak_iarr, int,     NULL)
-    PAK_INIT_ARR(pak_larr, long,    NULL)
-    PAK_INIT_ARR(pak_darr, double,  NULL)
-    PAK_INIT_ARR(pak_farr, float,   NULL)
-    PAK_INIT_ARR(pak_carr, char,    NULL)
-    PAK_INIT_ARR(pak_sarr, char*,   NULL)
+/* Default comparator for PAK_INIT_ARR_SORT */
+#define PAK_ARR_LESS(A, B) ((A) < (B))
+
+/* Typed introsort, "LESS(a, b)" is a macro or function returning true if a < b */
+#define PAK_INIT_ARR_SORT(NAME, TYPE, LESS)                                         \
+    static void NAME##__insertion_sort(TYPE *a, pak_size n)                         \
+    {                                                                               \
+        pak_size i, j;                                                              \
+                                                                                    \
+        for (i = 1; i < n; i++) {                                                   \
+            TYPE tmp = a[i];                                                        \
+                                                                                    \
+            for (j = i; j > 0 && LESS(tmp, a[j - 1]); j--)                          \
+                a[j] = a[j - 1];                                                    \
+                                                                                    \
+            a[j] = tmp;                                                             \
+        }                                                                           \
+    }                                                                               \
+                                                                                    \
+    static void NAME##__sift_down(TYPE *a, pak_size root, pak_size n)               \
+    {                                                                               \
+        TYPE tmp = a[root];                                                         \
+        pak_size child;                                                             \
+                                                                                    \
+        while ((child = 2 * root + 1) < n) {                                        \
+            if (child + 1 < n && LESS(a[child], a[child + 1]))                      \
+                child++;                                                            \
+                                                                                    \
+            if (!LESS(tmp, a[child]))                                               \
+                break;                                                              \
+                                                                                    \
+            a[root] = a[child];                                                     \
+            root = child;                                                           \
+        }                                                                           \
+                                                                                    \
+        a[root] = tmp;                                                              \
+    }                                                                               \
+                                                                                    \
+    static void NAME##__heap_sort(TYPE *a, pak_size n)                              \
+    {                                                                               \
+        pak_size i;                                                                 \
+                                                                                    \
+        for (i = n / 2 - 1; i >= 0; i--)                                            \
+            NAME##__sift_down(a, i, n);                                             \
+                                                                                    \
+        for (i = n - 1; i > 0; i--) {                                               \
+            TYPE tmp = a[0];                                                        \
+            a[0] = a[i];                                                            \
+            a[i] = tmp;                                                             \
+                                                                                    \
+            NAME##__sift_down(a, 0, i);                                             \
+        }                                                                           \
+    }                                                                               \
+                                                                                    \
+    static void NAME##__intro_sort(TYPE *a, pak_size n, int depth)                  \
+    {                                                                               \
+        while (n > PAK_ARR_SORT_CUTOFF) {                                           \
+            TYPE pivot, tmp;                                                        \
+            pak_size i, j, mid;                                                     \
+                                                                                    \
+            /* Quicksort is going quadratic, fall back to heapsort */               \
+            if (depth-- == 0) {                                                     \
+                NAME##__heap_sort(a, n);                                            \
+                return;                                                             \
+            }                                                                       \
+                                                                                    \
+            /* Median of three */                                                   \
+            mid = (n - 1) / 2;                                                      \
+                                                                                    \
+            if (LESS(a[mid], a[0])) {                                               \
+                tmp = a[mid]; a[mid] = a[0]; a[0] = tmp;                            \
+            }                                                                       \
+                                                                                    \
+            if (LESS(a[n - 1], a[mid])) {                                           \
+                tmp = a[n - 1]; a[n - 1] = a[mid]; a[mid] = tmp;                    \
+                                                                                    \
+                if (LESS(a[mid], a[0])) {                                           \
+                    tmp = a[mid]; a[mid] = a[0]; a[0] = tmp;                        \
+                }                                                                   \
+            }                                                                       \
+                                                                                    \
+            /* Hoare partition, leaves [0, j] <= pivot <= [j + 1, n) */             \
+            pivot = a[mid];                                                         \
+            i = -1;                                                                 \
+            j = n;                                                                  \
+                                                                                    \
+            for (;;) {                                                              \
+                do i++; while (LESS(a[i], pivot));                                  \
+                do j--; while (LESS(pivot, a[j]));                                  \
+                                                                                    \
+                if (i >= j)                                                         \
+                    break;                                                          \
+                                                                                    \
+                tmp = a[i]; a[i] = a[j]; a[j] = tmp;                                \
+            }                                                                       \
+                                                                                    \
+            /* Recurse into the smaller half, and loop on the larger one */         \
+            if (j + 1 < n - j - 1) {                                                \
+                NAME##__intro_sort(a, j + 1, depth);                                \
+                a += j + 1;                                                         \
+                n -= j + 1;                                                         \
+            } else {                                                                \
+                NAME##__intro_sort(a + j + 1, n - j - 1, depth);                    \
+                n = j + 1;                                                          \
+            }                                                                       \
+        }                                                                           \
+                                                                                    \
+        NAME##__insertion_sort(a, n);                                               \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX void NAME##_sort(NAME arr)                                           \
+    {                                                                               \
+        pak_size n = pak_arr_count(arr);                                            \
+        int depth = 0;                                                              \
+                                                                                    \
+        while (n >>= 1)                                                             \
+            depth += 2;                                                             \
+                                                                                    \
+        NAME##__intro_sort(arr, pak_arr_count(arr), depth);                         \
+    }
+
+/* For header files */
+#define PAK_INIT_ARR_SORT_PROTOTYPES(NAME)                                          \
+    extern void NAME##_sort(NAME arr);
+
+/* Prefetching for searches over large arrays */
+#if defined(__GNUC__) || defined(__clang__)
+#   define PAK_PREFETCH(P) __builtin_prefetch(P)
 #else
-#ifndef PAK_STATIC
-    PAK_INIT_ARR_PROTOTYPES(pak_iarr, int)
-    PAK_INIT_ARR_PROTOTYPES(pak_larr, long)
-    PAK_INIT_ARR_PROTOTYPES(pak_darr, double)
-    PAK_INIT_ARR_PROTOTYPES(pak_farr, float)
-    PAK_INIT_ARR_PROTOTYPES(pak_carr, char)
-    PAK_INIT_ARR_PROTOTYPES(pak_sarr, char*)
+#   define PAK_PREFETCH(P) ((void)0)
+#endif
+
+/* Typed binary searches over an array sorted by "LESS", see PAK_INIT_ARR_SORT */
+#define PAK_INIT_ARR_SEARCH(NAME, TYPE, LESS)                                                       \
+    /* Index of the first element not less than "key", or the count if none */                      \
+    PAK_PREFIX pak_size NAME##_lower_bound(NAME arr, TYPE key)                                      \
+    {                                                                                               \
+        pak_size lo = 0, hi = pak_arr_count(arr);                                                   \
+                                                                                                    \
+        while (lo < hi) {                                                                           \
+            pak_size mid = lo + (hi - lo) / 2;                                                      \
+                                                                                                    \
+            if (LESS(arr[mid], key))                                                                \
+                lo = mid + 1;                                                                       \
+            else                                                                                    \
+                hi = mid;                                                                           \
+        }                                                                                           \
+                                                                                                    \
+        return lo;                                                                                  \
+    }                                                                                               \
+                                                                                                    \
+    /* Index of the first element greater than "key", or the count if none */                       \
+    PAK_PREFIX pak_size NAME##_upper_bound(NAME arr, TYPE key)                                      \
+    {                                                                                               \
+        pak_size lo = 0, hi = pak_arr_count(arr);                                                   \
+                                                                                                    \
+        while (lo < hi) {                                                                           \
+            pak_size mid = lo + (hi - lo) / 2;                                                      \
+                                                                                                    \
+            if (LESS(key, arr[mid]))                                                                \
+                hi = mid;                                                                           \
+            else                                                                                    \
+                lo = mid + 1;                                                                       \
+        }                                                                                           \
+                                                                                                    \
+        return lo;                                                                                  \
+    }                                                                                               \
+                                                                                                    \
+    /* Stores the range [first, last) of elements equal to "key", returns its length */             \
+    PAK_PREFIX pak_size NAME##_equal_range(NAME arr, TYPE key, pak_size *first, pak_size *last)     \
+    {                                                                                               \
+        pak_size lo = NAME##_lower_bound(arr, key), hi = pak_arr_count(arr);                        \
+                                                                                                    \
+        *first = lo;                                                                                \
+        while (lo < hi) {                                                                           \
+            pak_size mid = lo + (hi - lo) / 2;                                                      \
+                                                                                                    \
+            if (LESS(key, arr[mid]))                                                                \
+                hi = mid;                                                                           \
+            else                                                                                    \
+                lo = mid + 1;                                                                       \
+        }                                                                                           \
+        *last = lo;                                                                                 \
+                                                                                                    \
+        return *last - *first;                                                                      \
+    }                                                                                               \
+                                                                                                    \
+    PAK_PREFIX int NAME##_contains(NAME arr, TYPE key)                                              \
+    {                                                                                               \
+        pak_size i = NAME##_lower_bound(arr, key);                                                  \
+        return i < pak_arr_count(arr) && !LESS(key, arr[i]);                                        \
+    }                                                                                               \
+                                                                                                    \
+    /* Same as lower_bound, but the loop has a fixed trip count and no branches */                  \
+    PAK_PREFIX pak_size NAME##_lower_bound_branchless(NAME arr, TYPE key)                           \
+    {                                                                                               \
+        const TYPE *base = arr;                                                                     \
+        pak_size n = pak_arr_count(arr);                                                            \
+                                                                                                    \
+        if (n == 0)                                                                                 \
+            return 0;                                                                               \
+                                                                                                    \
+        while (n > 1) {                                                                             \
+            pak_size half = n / 2;                                                                  \
+            base = LESS(base[half], key) ? base + half : base;                                      \
+            n -= half;                                                                              \
+        }                                                                                           \
+                                                                                                    \
+        return (pak_size)(base - arr) + (LESS(*base, key) ? 1 : 0);                                 \
+    }                                                                                               \
+                                                                                                    \
+    static void NAME##__eytzinger_fill(NAME eyt, NAME sorted, pak_size *pos,                        \
+                                       pak_size k, pak_size n)                                      \
+    {                                                                                               \
+        if (k < n) {                                                                                \
+            NAME##__eytzinger_fill(eyt, sorted, pos, 2 * k + 1, n);                                 \
+            eyt[k] = sorted[(*pos)++];                                                              \
+            NAME##__eytzinger_fill(eyt, sorted, pos, 2 * k + 2, n);                                 \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    /* Copies a sorted array into a new cache aligned array in Eytzinger (BFS) order */             \
+    PAK_PREFIX NAME NAME##_eytzinger(NAME sorted)                                                   \
+    {                                                                                               \
+        pak_size n = pak_arr_count(sorted);                                                         \
+        pak_size pos = 0;                                                                           \
+        NAME eyt = NULL;                                                                            \
+                                                                                                    \
+        eyt = (NAME)pak__arr_new_ex(sizeof(TYPE), n > 0 ? n : 1, NULL, pak_arr_growth_add(),        \
+                                    64, pak_arr_header(sorted)->alloc);                             \
+        pak_assert(eyt);                                                                            \
+                                                                                                    \
+        NAME##__eytzinger_fill(eyt, sorted, &pos, 0, n);                                            \
+        pak_arr_count(eyt) = n;                                                                     \
+                                                                                                    \
+        return eyt;                                                                                 \
+                                                                                                    \
+    fail:                                                                                           \
+        return NULL;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    /* Index in an Eytzinger array of the first element not less than "key", or -1 */               \
+    PAK_PREFIX pak_size NAME##_eytzinger_lower_bound(NAME eyt, TYPE key)                            \
+    {                                                                                               \
+        pak_size n = pak_arr_count(eyt);                                                            \
+        size_t k = 1, ahead = 2;                                                                    \
+                                                                                                    \
+        /* Prefetch the level of descendants which fills a cache line, the 16 nodes */              \
+        /* four levels down for 4 byte elements, or just the two children for large ones */         \
+        while (ahead * 2 * sizeof(TYPE) <= 64)                                                      \
+            ahead *= 2;                                                                             \
+                                                                                                    \
+        /* Walk down with 1-based indices, prefetching those descendants while they exist */        \
+        while (k <= (size_t)n) {                                                                    \
+            if (k <= (size_t)n / ahead)                                                             \
+                PAK_PREFETCH(eyt + ahead * k - 1);                                                  \
+            k = 2 * k + (LESS(eyt[k - 1], key) ? 1 : 0);                                            \
+        }                                                                                           \
+                                                                                                    \
+        /* Undo the right turns taken after the last left one */                                    \
+        while (k & 1)                                                                               \
+            k >>= 1;                                                                                \
+        k >>= 1;                                                                                    \
+                                                                                                    \
+        return (pak_size)k - 1;                                                                     \
+    }
+
+/* For header files */
+#define PAK_INIT_ARR_SEARCH_PROTOTYPES(NAME, TYPE)                                                  \
+    extern pak_size NAME##_lower_bound(NAME arr, TYPE key);                                         \
+    extern pak_size NAME##_upper_bound(NAME arr, TYPE key);                                         \
+    extern pak_size NAME##_equal_range(NAME arr, TYPE key, pak_size *first, pak_size *last);        \
+    extern int NAME##_contains(NAME arr, TYPE key);                                                 \
+    extern pak_size NAME##_lower_bound_branchless(NAME arr, TYPE key);                              \
+    extern NAME NAME##_eytzinger(NAME sorted);                                                      \
+    extern pak_size NAME##_eytzinger_lower_bound(NAME eyt, TYPE key);
+
+/* Struct of arrays columns are aligned to this, which should be at least the SIMD width */
+#ifndef PAK_SOA_ALIGN
+#   define PAK_SOA_ALIGN 64
+#endif
+
+/* Preprocessor loop over up to 16 "(TYPE, field)" tuples, calling "M(NAME, (TYPE, field))" */
+#define PAK__SOA_NARGS(...) PAK__SOA_NARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)
+#define PAK__SOA_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, N, ...) N
+#define PAK__SOA_CAT(A, B)  PAK__SOA_CAT_(A, B)
+#define PAK__SOA_CAT_(A, B) A##B
+#define PAK__SOA_TYPE(T, F)  T
+#define PAK__SOA_FIELD(T, F) F
+#define PAK__SOA_EACH(M, N, ...)\
+    PAK__SOA_CAT(PAK__SOA_EACH_, PAK__SOA_NARGS(__VA_ARGS__))(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_1(M, N, F) M(N, F)
+#define PAK__SOA_EACH_2(M, N, F, ...) M(N, F) PAK__SOA_EACH_1(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_3(M, N, F, ...) M(N, F) PAK__SOA_EACH_2(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_4(M, N, F, ...) M(N, F) PAK__SOA_EACH_3(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_5(M, N, F, ...) M(N, F) PAK__SOA_EACH_4(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_6(M, N, F, ...) M(N, F) PAK__SOA_EACH_5(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_7(M, N, F, ...) M(N, F) PAK__SOA_EACH_6(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_8(M, N, F, ...) M(N, F) PAK__SOA_EACH_7(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_9(M, N, F, ...) M(N, F) PAK__SOA_EACH_8(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_10(M, N, F, ...) M(N, F) PAK__SOA_EACH_9(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_11(M, N, F, ...) M(N, F) PAK__SOA_EACH_10(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_12(M, N, F, ...) M(N, F) PAK__SOA_EACH_11(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_13(M, N, F, ...) M(N, F) PAK__SOA_EACH_12(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_14(M, N, F, ...) M(N, F) PAK__SOA_EACH_13(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_15(M, N, F, ...) M(N, F) PAK__SOA_EACH_14(M, N, __VA_ARGS__)
+#define PAK__SOA_EACH_16(M, N, F, ...) M(N, F) PAK__SOA_EACH_15(M, N, __VA_ARGS__)
+
+/* Pieces generated once per column */
+#define PAK__SOA_MEMBER(N, C)    PAK__SOA_TYPE C *PAK__SOA_FIELD C;
+#define PAK__SOA_PARAM(N, C)     , PAK__SOA_TYPE C PAK__SOA_FIELD C
+#define PAK__SOA_NULL(N, C)      soa->PAK__SOA_FIELD C = NULL;
+#define PAK__SOA_FREE(N, C)      if (soa->PAK__SOA_FIELD C) pak_arr_free(&soa->PAK__SOA_FIELD C);
+#define PAK__SOA_RESIZE(N, C)    pak_assert(pak_arr_resize(&soa->PAK__SOA_FIELD C, max) == 0);
+#define PAK__SOA_STORE(N, C)     soa->PAK__SOA_FIELD C[soa->count] = PAK__SOA_FIELD C;
+#define PAK__SOA_MOVE(N, C)      soa->PAK__SOA_FIELD C[index] = soa->PAK__SOA_FIELD C[soa->count];
+#define PAK__SOA_NEW(N, C)                                                          \
+    soa->PAK__SOA_FIELD C = (PAK__SOA_TYPE C *)pak__arr_new_ex(                     \
+            sizeof(PAK__SOA_TYPE C), max, NULL, pak_arr_growth_add(), PAK_SOA_ALIGN,\
+            alloc);                                                                 \
+    pak_assert(soa->PAK__SOA_FIELD C);
+#define PAK__SOA_COLUMN(N, C)           PAK__SOA_COLUMN_(N, PAK__SOA_TYPE C, PAK__SOA_FIELD C)
+#define PAK__SOA_COLUMN_(N, T, F)       PAK__SOA_COLUMN__(N, T, F)
+#define PAK__SOA_COLUMN__(N, T, F)      PAK_PREFIX T *N##_col_##F(N soa) { return soa->F; }
+#define PAK__SOA_COLUMN_PROTOTYPE(N, C) PAK__SOA_COLUMN_PROTOTYPE_(N, PAK__SOA_TYPE C, PAK__SOA_FIELD C)
+#define PAK__SOA_COLUMN_PROTOTYPE_(N, T, F)  PAK__SOA_COLUMN_PROTOTYPE__(N, T, F)
+#define PAK__SOA_COLUMN_PROTOTYPE__(N, T, F) extern T *N##_col_##F(N soa);
+
+#define PAK__INIT_SOA_TYPE(NAME, ...)                                               \
+    typedef struct {                                                                \
+        PAK__SOA_EACH(PAK__SOA_MEMBER, NAME, __VA_ARGS__)                           \
+        pak_size count;                                                             \
+        pak_size max;                                                               \
+        const pak_allocator *alloc;                                                 \
+    } NAME##_;                                                                      \
+                                                                                    \
+    typedef NAME##_* NAME;
+
+/* Struct of arrays, one aligned PAK array per "(TYPE, field)" with a shared count */
+#define PAK_INIT_SOA(NAME, ...)                                                     \
+    PAK__INIT_SOA_TYPE(NAME, __VA_ARGS__)                                           \
+                                                                                    \
+    PAK_PREFIX void NAME##_free(NAME *pp)                                           \
+    {                                                                               \
+        NAME soa = *pp;                                                             \
+                                                                                    \
+        pak_assert(soa); /* Double free? */                                         \
+                                                                                    \
+        PAK__SOA_EACH(PAK__SOA_FREE, NAME, __VA_ARGS__)                             \
+        pak__free(soa->alloc, soa);                                                 \
+                                                                                    \
+        *pp = NULL;                                                                 \
+                                                                                    \
+    fail:                                                                           \
+        return;                                                                     \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new_alloc(pak_size max, const pak_allocator *alloc)      \
+    {                                                                               \
+        NAME soa = NULL;                                                            \
+                                                                                    \
+        pak_assert(max > 0);                                                        \
+                                                                                    \
+        soa = (NAME)pak__alloc(alloc, sizeof(*soa));                                \
+        pak_assert(soa);                                                            \
+                                                                                    \
+        PAK__SOA_EACH(PAK__SOA_NULL, NAME, __VA_ARGS__)                             \
+        soa->count = 0;                                                             \
+        soa->max = max;                                                             \
+        soa->alloc = alloc;                                                         \
+                                                                                    \
+        PAK__SOA_EACH(PAK__SOA_NEW, NAME, __VA_ARGS__)                              \
+                                                                                    \
+        return soa;                                                                 \
+                                                                                    \
+    fail:                                                                           \
+        if (soa)                                                                    \
+            NAME##_free(&soa);                                                      \
+                                                                                    \
+        return NULL;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new(pak_size max)                                        \
+    {                                                                               \
+        return NAME##_new_alloc(max, NULL);                                         \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX pak_size NAME##_count(NAME soa) { return soa->count; }               \
+    PAK_PREFIX pak_size NAME##_max(NAME soa)   { return soa->max; }                 \
+                                                                                    \
+    /* Columns which grew before a failure just keep the extra room */              \
+    PAK_PREFIX int NAME##_reserve(NAME soa, pak_size max)                           \
+    {                                                                               \
+        if (max <= soa->max)                                                        \
+            return 0;                                                               \
+                                                                                    \
+        PAK__SOA_EACH(PAK__SOA_RESIZE, NAME, __VA_ARGS__)                           \
+        soa->max = max;                                                             \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_push(NAME soa                                             \
+                               PAK__SOA_EACH(PAK__SOA_PARAM, NAME, __VA_ARGS__))    \
+    {                                                                               \
+        if (soa->count >= soa->max)                                                 \
+            pak_assert(soa->max <= PAK_SIZE_MAX / 2 &&                              \
+                       NAME##_reserve(soa, soa->max * 2) == 0);                     \
+                                                                                    \
+        PAK__SOA_EACH(PAK__SOA_STORE, NAME, __VA_ARGS__)                            \
+        soa->count++;                                                               \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_pop(NAME soa)                                             \
+    {                                                                               \
+        pak_assert(soa->count > 0);                                                 \
+        soa->count--;                                                               \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    /* Moves the last row over "index", which breaks order */                       \
+    PAK_PREFIX int NAME##_swap_remove(NAME soa, pak_size index)                     \
+    {                                                                               \
+        pak_assert(0 <= index && index < soa->count);                               \
+                                                                                    \
+        soa->count--;                                                               \
+        PAK__SOA_EACH(PAK__SOA_MOVE, NAME, __VA_ARGS__)                             \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    PAK__SOA_EACH(PAK__SOA_COLUMN, NAME, __VA_ARGS__)
+
+/* For header files */
+#define PAK_INIT_SOA_PROTOTYPES(NAME, ...)                                          \
+    PAK__INIT_SOA_TYPE(NAME, __VA_ARGS__)                                           \
+                                                                                    \
+    extern void NAME##_free(NAME *pp);                                              \
+    extern NAME NAME##_new_alloc(pak_size max, const pak_allocator *alloc);         \
+    extern NAME NAME##_new(pak_size max);                                           \
+    extern pak_size NAME##_count(NAME soa);                                         \
+    extern pak_size NAME##_max(NAME soa);                                           \
+    extern int NAME##_reserve(NAME soa, pak_size max);                              \
+    extern int NAME##_push(NAME soa                                                 \
+                           PAK__SOA_EACH(PAK__SOA_PARAM, NAME, __VA_ARGS__));       \
+    extern int NAME##_pop(NAME soa);                                                \
+    extern int NAME##_swap_remove(NAME soa, pak_size index);                        \
+    PAK__SOA_EACH(PAK__SOA_COLUMN_PROTOTYPE, NAME, __VA_ARGS__)
+
+/* Parallel sorting uses pthreads where available, define PAK_NO_THREADS to run the
+   same algorithm on the calling thread only */
+#if !defined(PAK_NO_THREADS) && !defined(_WIN32)
+#   define PAK__ARR_THREADS
+#endif
+
+#ifndef PAK_ARR_MAX_THREADS
+#   define PAK_ARR_MAX_THREADS 64
+#endif
+
+/* Arrays are never split into chunks smaller than this when sorting in parallel */
+#ifndef PAK_ARR_PARALLEL_MIN
+#   define PAK_ARR_PARALLEL_MIN 4096
+#endif
+
+/* Sorts "V" with "N" threads, each sorting a chunk with qsort before the chunks are
+   merged together in parallel. Returns -1 if the scratch array can not be made. */
+PAK_PREFIX int pak__arr_parallel_sort(void *arr, int (*cmp)(const void *, const void *), int threads);
+#define pak_arr_parallel_sort(V, CMP, N) pak__arr_parallel_sort((void *) (V), (CMP), (N))
+
+/* LSD radix sorts for the common number arrays, returns -1 if out of memory */
+PAK_PREFIX int pak_iarr_radix_sort(int *arr);
+PAK_PREFIX int pak_larr_radix_sort(long *arr);
+PAK_PREFIX int pak_farr_radix_sort(float *arr);
+PAK_PREFIX int pak_darr_radix_sort(double *arr);
+
+/* Define commmon types for PAK arr */
+#ifdef PAK_IMPLEMENTATION
+    PAK_INIT_ARR(pak_iarr, int,     NULL)
+    PAK_INIT_ARR(pak_larr, long,    NULL)
+    PAK_INIT_ARR(pak_darr, double,  NULL)
+    PAK_INIT_ARR(pak_farr, float,   NULL)
+    PAK_INIT_ARR(pak_carr, char,    NULL)
+    PAK_INIT_ARR(pak_sarr, char*,   NULL)
+
+    PAK_INIT_ARR_SORT(pak_iarr, int,    PAK_ARR_LESS)
+    PAK_INIT_ARR_SORT(pak_larr, long,   PAK_ARR_LESS)
+    PAK_INIT_ARR_SORT(pak_darr, double, PAK_ARR_LESS)
+    PAK_INIT_ARR_SORT(pak_farr, float,  PAK_ARR_LESS)
+
+    PAK_INIT_ARR_SEARCH(pak_iarr, int,    PAK_ARR_LESS)
+    PAK_INIT_ARR_SEARCH(pak_larr, long,   PAK_ARR_LESS)
+    PAK_INIT_ARR_SEARCH(pak_darr, double, PAK_ARR_LESS)
+    PAK_INIT_ARR_SEARCH(pak_farr, float,  PAK_ARR_LESS)
+#else
+#ifndef PAK_STATIC
+    PAK_INIT_ARR_PROTOTYPES(pak_iarr, int)
+    PAK_INIT_ARR_PROTOTYPES(pak_larr, long)
+    PAK_INIT_ARR_PROTOTYPES(pak_darr, double)
+    PAK_INIT_ARR_PROTOTYPES(pak_farr, float)
+    PAK_INIT_ARR_PROTOTYPES(pak_carr, char)
+    PAK_INIT_ARR_PROTOTYPES(pak_sarr, char*)
+
+    PAK_INIT_ARR_SORT_PROTOTYPES(pak_iarr)
+    PAK_INIT_ARR_SORT_PROTOTYPES(pak_larr)
+    PAK_INIT_ARR_SORT_PROTOTYPES(pak_darr)
+    PAK_INIT_ARR_SORT_PROTOTYPES(pak_farr)
+
+    PAK_INIT_ARR_SEARCH_PROTOTYPES(pak_iarr, int)
+    PAK_INIT_ARR_SEARCH_PROTOTYPES(pak_larr, long)
+    PAK_INIT_ARR_SEARCH_PROTOTYPES(pak_darr, double)
+    PAK_INIT_ARR_SEARCH_PROTOTYPES(pak_farr, float)
+#endif
+#endif
+
+/* List the common types under the line calling their constructors, see "Statistics"
+   above. These have to follow the definitions, which they would otherwise rename */
+#ifdef PAK_ARR_STATS
+#   define PAK__ARR_SITED(NAME, A) ((NAME) PAK__ARR_SITE(A))
+#   define pak_iarr_new(M)          PAK__ARR_SITED(pak_iarr, pak_iarr_new(M))
+#   define pak_iarr_new_alloc(M, A) PAK__ARR_SITED(pak_iarr, pak_iarr_new_alloc((M), (A)))
+#   define pak_iarr_new_buf(B, S)   PAK__ARR_SITED(pak_iarr, pak_iarr_new_buf((B), (S)))
+#   define pak_iarr_map_file(P, F)  PAK__ARR_SITED(pak_iarr, pak_iarr_map_file((P), (F)))
+#   define pak_larr_new(M)          PAK__ARR_SITED(pak_larr, pak_larr_new(M))
+#   define pak_larr_new_alloc(M, A) PAK__ARR_SITED(pak_larr, pak_larr_new_alloc((M), (A)))
+#   define pak_larr_new_buf(B, S)   PAK__ARR_SITED(pak_larr, pak_larr_new_buf((B), (S)))
+#   define pak_larr_map_file(P, F)  PAK__ARR_SITED(pak_larr, pak_larr_map_file((P), (F)))
+#   define pak_darr_new(M)          PAK__ARR_SITED(pak_darr, pak_darr_new(M))
+#   define pak_darr_new_alloc(M, A) PAK__ARR_SITED(pak_darr, pak_darr_new_alloc((M), (A)))
+#   define pak_darr_new_buf(B, S)   PAK__ARR_SITED(pak_darr, pak_darr_new_buf((B), (S)))
+#   define pak_darr_map_file(P, F)  PAK__ARR_SITED(pak_darr, pak_darr_map_file((P), (F)))
+#   define pak_farr_new(M)          PAK__ARR_SITED(pak_farr, pak_farr_new(M))
+#   define pak_farr_new_alloc(M, A) PAK__ARR_SITED(pak_farr, pak_farr_new_alloc((M), (A)))
+#   define pak_farr_new_buf(B, S)   PAK__ARR_SITED(pak_farr, pak_farr_new_buf((B), (S)))
+#   define pak_farr_map_file(P, F)  PAK__ARR_SITED(pak_farr, pak_farr_map_file((P), (F)))
+#   define pak_carr_new(M)          PAK__ARR_SITED(pak_carr, pak_carr_new(M))
+#   define pak_carr_new_alloc(M, A) PAK__ARR_SITED(pak_carr, pak_carr_new_alloc((M), (A)))
+#   define pak_carr_new_buf(B, S)   PAK__ARR_SITED(pak_carr, pak_carr_new_buf((B), (S)))
+#   define pak_carr_map_file(P, F)  PAK__ARR_SITED(pak_carr, pak_carr_map_file((P), (F)))
+#   define pak_sarr_new(M)          PAK__ARR_SITED(pak_sarr, pak_sarr_new(M))
+#   define pak_sarr_new_alloc(M, A) PAK__ARR_SITED(pak_sarr, pak_sarr_new_alloc((M), (A)))
+#   define pak_sarr_new_buf(B, S)   PAK__ARR_SITED(pak_sarr, pak_sarr_new_buf((B), (S)))
+#   define pak_sarr_map_file(P, F)  PAK__ARR_SITED(pak_sarr, pak_sarr_map_file((P), (F)))
+#endif
+
+/* Begin function definitions */
+#ifdef PAK_IMPLEMENTATION
+
+/* Bytes to allocate for "max" elements, or 0 if that does not fit in a size_t */
+PAK_PREFIX size_t pak__arr_alloc_sz(size_t sz, pak_size max, size_t align)
+{
+    size_t extra = sizeof(pak__arr) + (align ? align - 1 : 0);
+
+    if (max < 0 || (sz > 0 && (size_t)max > ((size_t)-1 - extra) / sz))
+        return 0;
+
+    return extra + sz * (size_t)max;
+}
+
+PAK_PREFIX size_t pak__arr_pad(void *base, size_t align)
+{
+    uintptr_t data = (uintptr_t)base + sizeof(pak__arr);
+
+    if (!align)
+        return 0;
+
+    return ((data + align - 1) & ~(uintptr_t)(align - 1)) - data;
+}
+
+PAK_PREFIX void *pak__arr_new(size_t sz, pak_size max)
+{
+    return pak__arr_new_aligned(sz, max, 0);
+}
+
+PAK_PREFIX void *pak__arr_new_aligned(size_t sz, pak_size max, size_t align)
+{
+    return pak__arr_new_ex(sz, max, NULL, pak_arr_growth_add(), align, NULL);
+}
+
+PAK_PREFIX void *pak__arr_new_alloc(size_t sz, pak_size max, const pak_allocator *alloc)
+{
+    return pak__arr_new_ex(sz, max, NULL, pak_arr_growth_add(), 0, alloc);
+}
+
+PAK_PREFIX void *pak__arr_new_ex(size_t sz, pak_size max, pak__arr_gc gc, pak_arr_growth growth,
+                                 size_t align, const pak_allocator *alloc)
+{
+    char *base = NULL;
+    pak__arr *head = NULL;
+    size_t pad, len;
+
+    pak_assert(max > 0);
+    pak_assert((align & (align - 1)) == 0); /* Power of two */
+
+    len = pak__arr_alloc_sz(sz, max, align);
+    pak_assert(len);
+
+    base = (char *)pak__alloc(alloc, len);
+    pak_assert(base);
+
+    pad = pak__arr_pad(base, align);
+    head = (pak__arr *)(base + pad);
+
+    head->count = 0;
+    head->max = max;
+    head->min = max;
+    head->rate = max;
+    head->growth = pak_arr_growth_add();
+    head->elem_sz = sz;
+    head->align = align;
+    head->pad = pad;
+    head->sig = PAK_ARR_SIGNATURE;
+    head->flags = 0;
+    head->fd = -1;
+    head->gc = gc;
+    head->gc_range = NULL;
+    head->alloc = alloc;
+    PAK__ARR_STATS_INIT(head);
+
+    pak_assertp(pak__arr_set_growth(head + 1, growth) == 0, pak__free(alloc, base));
+
+    return head + 1;
+
+fail:
+    return NULL;
+}
+
+PAK_PREFIX void *pak__arr_new_gc(size_t sz, pak_size max, pak__arr_gc gc)
+{
+    void *arr = pak__arr_new(sz, max);
+    pak_assert(arr);
+
+    pak_arr_header(arr)->gc = gc;
+
+    return arr;
+
+fail:
+    return NULL;
+}
+
+PAK_PREFIX void *pak__arr_new_buf(size_t sz, void *buf, size_t buf_sz, size_t align)
+{
+    pak__arr *head = NULL;
+    size_t pad;
+    pak_size max;
+
+    pak_assert(buf);
+    pak_assert((align & (align - 1)) == 0); /* Power of two */
+
+    pad = pak__arr_pad(buf, align);
+    pak_assert(buf_sz > pad + sizeof(*head));
+
+    head = (pak__arr *)((char *)buf + pad);
+    max = (pak_size)((buf_sz - pad - sizeof(*head)) / sz);
+    pak_assert(max > 0);
+
+    head->count = 0;
+    head->max = max;
+    head->min = max;
+    head->rate = max;
+    head->growth = pak_arr_growth_add();
+    head->elem_sz = sz;
+    head->align = align;
+    head->pad = pad;
+    head->sig = PAK_ARR_SIGNATURE;
+    head->flags = PAK_ARR_INLINE;
+    head->fd = -1;
+    head->gc = NULL;
+    head->gc_range = NULL;
+    head->alloc = NULL;
+    PAK__ARR_STATS_INIT(head);
+
+    return head + 1;
+
+fail:
+    return NULL;
+}
+
+PAK_PREFIX void *pak__arr_new_growth(size_t sz, pak_size max, pak__arr_gc gc, pak_arr_growth growth)
+{
+    return pak__arr_new_ex(sz, max, gc, growth, 0, NULL);
+}
+
+PAK_PREFIX pak_arr_growth pak_arr_growth_add(void)
+{
+    pak_arr_growth growth;
+
+    growth.policy = PAK_ARR_GROW_ADD;
+    growth.factor = 0.0f;
+    growth.fn = NULL;
+
+    return growth;
+}
+
+PAK_PREFIX pak_arr_growth pak_arr_growth_mul(float factor)
+{
+    pak_arr_growth growth;
+
+    growth.policy = PAK_ARR_GROW_MUL;
+    growth.factor = factor;
+    growth.fn = NULL;
+
+    return growth;
+}
+
+PAK_PREFIX pak_arr_growth pak_arr_growth_func(pak__arr_grow fn)
+{
+    pak_arr_growth growth;
+
+    growth.policy = PAK_ARR_GROW_FUNC;
+    growth.factor = 0.0f;
+    growth.fn = fn;
+
+    return growth;
+}
+
+PAK_PREFIX int pak__arr_set_growth(void *arr, pak_arr_growth growth)
+{
+    pak__arr *head = pak_arr_header(arr);
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+
+    if (growth.policy == PAK_ARR_GROW_MUL)
+        pak_assert(growth.factor > 1.0f);
+
+    if (growth.policy == PAK_ARR_GROW_FUNC)
+        pak_assert(growth.fn);
+
+    head->growth = growth;
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+PAK_PREFIX int pak__arr_set_gc_range(void *arr, pak__arr_gc_range gc_range)
+{
+    pak__arr *head = pak_arr_header(arr);
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+
+    head->gc_range = gc_range;
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+/* Smallest max the growth policy allows which can hold "need" elements */
+static pak_size pak__arr_grow_max(const pak__arr *head, pak_size need)
+{
+    pak_size max = head->max, steps;
+
+    if (need <= max)
+        return max;
+
+    /* Steps which would go past PAK_SIZE_MAX settle for exactly "need" instead */
+    switch (head->growth.policy) {
+    case PAK_ARR_GROW_MUL:
+        while (max < need) {
+            double next = max * (double)head->growth.factor;
+            if (next >= (double)PAK_SIZE_MAX)
+                return need;
+            max = ((pak_size)next > max) ? (pak_size)next : max + 1;
+        }
+        break;
+
+    case PAK_ARR_GROW_FUNC:
+        max = head->growth.fn(max, need);
+        if (max < need)
+            return -1;
+        break;
+
+    default:
+        /* Round up to the next multiple of rate in one step */
+        steps = (need - max - 1) / head->rate + 1;
+        if (steps > (PAK_SIZE_MAX - max) / head->rate)
+            return need;
+        max += steps * head->rate;
+        break;
+    }
+
+    return max;
+}
+
+/* The next max down, never going below the minimum max */
+static pak_size pak__arr_shrink_max(const pak__arr *head)
+{
+    pak_size max;
+
+    if (head->growth.policy == PAK_ARR_GROW_MUL)
+        max = (pak_size)(head->max / head->growth.factor);
+    else
+        max = head->max - head->rate;
+
+    return (max > head->min) ? max : head->min;
+}
+
+/* Smallest max below the current one which still holds "need" elements,
+   stepping down the same way the growth policy steps up */
+static pak_size pak__arr_fit_max(const pak__arr *head, pak_size need)
+{
+    pak_size max = head->max;
+
+    if (head->growth.policy == PAK_ARR_GROW_MUL) {
+        for (;;) {
+            pak_size next = (pak_size)(max / head->growth.factor);
+            if (next < need || next < head->min || next >= max)
+                break;
+            max = next;
+        }
+    } else if (need < max) {
+        max = ((need + head->rate - 1) / head->rate) * head->rate;
+    }
+
+    return (max > head->min) ? max : head->min;
+}
+
+PAK_PREFIX void pak__arr_free(void **pp)
+{
+    void *arr = *pp;
+    pak__arr *head = NULL;
+
+    pak_assert(arr); /* Double free? */
+
+    head = pak_arr_header(arr);
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+
+    /* The count is left alone, mapped arrays keep it in their file */
+    pak__arr_destroy(arr, 0, head->count);
+
+    if (head->flags & PAK_ARR_MAPPED)
+        pak__arr_unmap(head);
+    else if (!(head->flags & PAK_ARR_INLINE))
+        pak__free(head->alloc, pak__arr_base(head));
+
+    *pp = NULL;
+
+fail:
+    return;
+}
+
+PAK_PREFIX int pak__arr_resize(void **pp, pak_size max)
+{
+    pak__arr *arr = NULL;
+    pak__arr *head = NULL;
+    char *base = NULL;
+    size_t align, pad, keep, len, copied;
+    uintptr_t old;
+
+    pak_assert(max > 0);
+
+    arr = *(pak__arr **) pp;
+    head = pak_arr_header(arr);
+
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+
+    len = pak__arr_alloc_sz(head->elem_sz, max, head->align);
+    pak_assert(len);
+
+    if (max < head->count) {
+        pak__arr_destroy(arr, max, head->count - max);
+        PAK__ARR_NOTE(head, 0, head->count - max, 0, 0);
+        head->count = max;
+    }
+
+    /* Inline buffers can not shrink, and move to the heap once they need to grow */
+    if (head->flags & PAK_ARR_INLINE)
+        return (max > head->max) ? pak__arr_spill(pp, max) : 0;
+
+    if (head->flags & PAK_ARR_MAPPED)
+        return pak__arr_remap(pp, max);
+
+    align = head->align;
+    pad = head->pad;
+    keep = sizeof(*head) + head->elem_sz * (max < head->max ? max : head->max);
+    old = (uintptr_t)pak__arr_base(head);
+
+    base = (char *)pak__realloc(head->alloc, pak__arr_base(head), len);
+    pak_assert(base);
+
+    /* realloc only had to copy if the block moved */
+    copied = ((uintptr_t)base != old) ? keep : 0;
+
+    /* realloc does not keep alignment, so slide everything over if needed */
+    head = (pak__arr *)(base + pak__arr_pad(base, align));
+
+    if ((char *)head != base + pad) {
+        memmove(head, base + pad, keep);
+        head->pad = (char *)head - base;
+        copied += keep;
+    }
+
+    head->max = max;
+    *pp = head + 1;
+
+    PAK__ARR_NOTE(head, 0, 0, 1, copied);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+PAK_PREFIX int pak__arr_spill(void **pp, pak_size max)
+{
+    pak__arr *head = pak_arr_header(*pp);
+    pak__arr *new_head = NULL;
+    char *base = NULL;
+    size_t len;
+
+    len = pak__arr_alloc_sz(head->elem_sz, max, head->align);
+    pak_assert(len);
+
+    base = (char *)pak__alloc(head->alloc, len);
+    pak_assert(base);
+
+    new_head = (pak__arr *)(base + pak__arr_pad(base, head->align));
+    memcpy(new_head, head, sizeof(*head) + head->elem_sz * head->count);
+
+    new_head->pad = (char *)new_head - base;
+    new_head->max = max;
+    new_head->flags &= ~PAK_ARR_INLINE;
+
+    PAK__ARR_NOTE(new_head, 0, 0, 1, sizeof(*head) + head->elem_sz * head->count);
+
+    *pp = new_head + 1;
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+#ifdef PAK__ARR_MMAP
+PAK_PREFIX void *pak__arr_map_file(const char *path, size_t sz, int flags)
+{
+    pak__arr *head = NULL;
+    void *base = MAP_FAILED;
+    size_t len = 0;
+    struct stat st;
+    int writable = flags & PAK_ARR_MAP_WRITE;
+    int mode = O_RDONLY;
+    int fd = -1;
+
+    pak_assert(path && sz > 0);
+    pak_assert(writable || !(flags & PAK_ARR_MAP_CREATE));
+
+    if (writable)
+        mode = O_RDWR | ((flags & PAK_ARR_MAP_CREATE) ? O_CREAT | O_TRUNC : 0);
+
+    fd = open(path, mode, 0644);
+    pak_assert(fd >= 0);
+    pak_assert(fstat(fd, &st) == 0);
+
+    /* Empty files get a header and room for one element */
+    len = (size_t)st.st_size;
+    if (len == 0) {
+        pak_assert(writable);
+        len = sizeof(*head) + sz;
+        pak_assert(ftruncate(fd, (off_t)len) == 0);
+    }
+
+    pak_assert(len >= sizeof(*head) && (len - sizeof(*head)) % sz == 0);
+
+    /* Private maps are copy on write, so the header can still be patched below */
+    base = mmap(NULL, len, PROT_READ | PROT_WRITE, writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    pak_assert(base != MAP_FAILED);
+    head = (pak__arr *)base;
+
+    if (st.st_size == 0) {
+        head->count = 0;
+        head->elem_sz = sz;
+        head->sig = PAK_ARR_SIGNATURE;
+    }
+
+    pak_assert(head->sig == PAK_ARR_SIGNATURE);
+    pak_assert(head->elem_sz == sz);
+
+    /* The capacity always comes from the file size */
+    pak_assert((len - sizeof(*head)) / sz <= (size_t)PAK_SIZE_MAX);
+    head->max = (pak_size)((len - sizeof(*head)) / sz);
+    pak_assert(head->count >= 0 && head->count <= head->max);
+
+    /* Everything else may point into whichever process wrote the file last */
+    head->min = 1;
+    head->rate = 1;
+    head->growth = pak_arr_growth_mul(2.0f);
+    head->align = 0;
+    head->pad = 0;
+    head->flags = PAK_ARR_MAPPED | (writable ? PAK_ARR_SHARED : 0);
+    head->gc = NULL;
+    head->gc_range = NULL;
+    head->alloc = NULL;
+    PAK__ARR_STATS_INIT(head);
+
+    /* Only shared maps need the file again, to grow it */
+    head->fd = writable ? fd : -1;
+    if (!writable)
+        close(fd);
+
+    return head + 1;
+
+fail:
+    if (base != MAP_FAILED)
+        munmap(base, len);
+    if (fd >= 0)
+        close(fd);
+    return NULL;
+}
+
+PAK_PREFIX int pak__arr_remap(void **pp, pak_size max)
+{
+    pak__arr *head = pak_arr_header(*pp);
+    size_t old_len = sizeof(*head) + head->elem_sz * head->max;
+    size_t len = sizeof(*head) + head->elem_sz * max;
+    void *base = NULL;
+
+    pak_assert(head->flags & PAK_ARR_SHARED);
+
+    /* Pages past the end of the file fault, so the file grows first and shrinks last */
+    if (max > head->max)
+        pak_assert(ftruncate(head->fd, (off_t)len) == 0);
+
+#ifdef MREMAP_MAYMOVE
+    base = mremap(head, old_len, len, MREMAP_MAYMOVE);
+    pak_assert(base != MAP_FAILED);
+#else
+    base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, head->fd, 0);
+    pak_assert(base != MAP_FAILED);
+    munmap(head, old_len);
+#endif
+
+    head = (pak__arr *)base;
+
+    /* If this fails the file is just left longer, the next map picks it up as extra room */
+    if (max < head->max)
+        (void)ftruncate(head->fd, (off_t)len);
+
+    head->max = max;
+    *pp = head + 1;
+
+    /* The pages are moved, not copied */
+    PAK__ARR_NOTE(head, 0, 0, 1, 0);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+PAK_PREFIX void pak__arr_unmap(pak__arr *head)
+{
+    int fd = head->fd;
+
+    munmap(head, sizeof(*head) + head->elem_sz * head->max);
+
+    if (fd >= 0)
+        close(fd);
+}
+#else
+PAK_PREFIX void *pak__arr_map_file(const char *path, size_t sz, int flags)
+{
+    (void)path; (void)sz; (void)flags;
+    return NULL;
+}
+
+PAK_PREFIX int pak__arr_remap(void **pp, pak_size max)
+{
+    (void)pp; (void)max;
+    return -1;
+}
+
+PAK_PREFIX void pak__arr_unmap(pak__arr *head)
+{
+    (void)head;
+}
+#endif /* PAK__ARR_MMAP */
+
+PAK_PREFIX int pak__arr_expand(void **pp)
+{
+    pak__arr *head = pak_arr_header(*pp);
+
+    if (head->max == PAK_SIZE_MAX)
+        return -1;
+
+    return pak__arr_resize(pp, pak__arr_grow_max(head, head->max + 1));
+}
+
+PAK_PREFIX int pak__arr_contract(void **pp)
+{
+    pak__arr *head = pak_arr_header(*pp);
+    return pak__arr_resize(pp, pak__arr_shrink_max(head));
+}
+
+PAK_PREFIX int pak__arr_reserve(void **pp, pak_size max)
+{
+    pak__arr *head = pak_arr_header(*pp);
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+
+    /* Pops will never shrink the array below the reserved size */
+    if (max > head->min)
+        head->min = max;
+
+    if (max > head->max)
+        return pak__arr_resize(pp, max);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+PAK_PREFIX int pak__arr_shrink_to_fit(void **pp)
+{
+    pak__arr *head = pak_arr_header(*pp);
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+
+    head->min = (head->count > 0) ? head->count : 1;
+
+    if (head->min == head->max)
+        return 0;
+
+    return pak__arr_resize(pp, head->min);
+
+fail:
+    return -1;
+}
+
+PAK_PREFIX int pak__arr_push(void **pp, size_t sz, void *e)
+{
+    pak__arr *arr = *(pak__arr **) pp;
+    pak__arr *head = pak_arr_header(arr);
+
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+    pak_arr_check(sz == head->elem_sz);
+
+    if (head->count >= head->max) {
+        pak_assert(pak_arr_expand(pp) == 0);
+        arr = *(pak__arr **) pp;
+        head = pak_arr_header(arr);
+    }
+
+    head->count++;
+    PAK__ARR_NOTE(head, 1, 0, 0, 0);
+
+    memcpy(pak_arr_notype_last(arr), e, sz);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+PAK_PREFIX int pak__arr_pop(void **pp)
+{
+    pak__arr *head = pak_arr_header(*pp);
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+
+    if (head->count > 0) {
+        pak__arr_destroy(*pp, head->count - 1, 1);
+
+        head->count--;
+        PAK__ARR_NOTE(head, 0, 1, 0, 0);
+        pak__arr_settle(pp);
+    }
+
+    return 0;
+        
+fail:
+    return -1;
+}
+
+PAK_PREFIX int pak__arr_grow_to(void **pp, pak_size need)
+{
+    pak__arr *head = pak_arr_header(*pp);
+
+    if (need <= head->max)
+        return 0;
+
+    return pak__arr_resize(pp, pak__arr_grow_max(head, need));
+}
+
+PAK_PREFIX void pak__arr_destroy(void *arr, pak_size first, pak_size n)
+{
+    pak__arr *head = pak_arr_header(arr);
+    char *e = (char *)arr + first * head->elem_sz;
+
+    if (n <= 0)
+        return;
+
+    if (head->gc_range)
+        head->gc_range(e, n);
+    else if (head->gc)
+        for (; n > 0; n--, e += head->elem_sz)
+            head->gc(e);
+}
+
+PAK_PREFIX void pak__arr_settle(void **pp)
+{
+    pak__arr *head = pak_arr_header(*pp);
+
+    /* Shrink to half full once below the ratio, so hovering around a
+       boundary does not realloc on every push and pop */
+    if (head->max > head->min && head->count < head->max / PAK_ARR_SHRINK_RATIO)
+        pak__arr_resize(pp, pak__arr_fit_max(head, head->count * 2));
+}
+
+PAK_PREFIX int pak__arr_push_n(void **pp, size_t sz, const void *e, pak_size n)
+{
+    char *arr = *(char **) pp;
+    pak__arr *head = pak_arr_header(arr);
+    size_t off = 0;
+    pak_bool inside;
+
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+    pak_arr_check(sz == head->elem_sz);
+    pak_assert(n >= 0 && n <= PAK_SIZE_MAX - head->count);
+
+    /* Remember where "e" was if it points into the array, since it may move */
+    inside = (const char *)e >= arr && (const char *)e < arr + head->count * sz;
+    if (inside)
+        off = (const char *)e - arr;
+
+    pak_assert(pak__arr_grow_to(pp, head->count + n) == 0);
+    arr = *(char **) pp;
+    head = pak_arr_header(arr);
+
+    if (inside)
+        e = arr + off;
+
+    memcpy(arr + head->count * sz, e, n * sz);
+    head->count += n;
+    PAK__ARR_NOTE(head, n, 0, 0, 0);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+PAK_PREFIX int pak__arr_extend(void **pp, const void *src)
+{
+    const pak__arr *head = pak_arr_header(src);
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+
+    return pak__arr_push_n(pp, head->elem_sz, src, head->count);
+
+fail:
+    return -1;
+}
+
+PAK_PREFIX int pak__arr_insert_range(void **pp, pak_size index, size_t sz, const void *e, pak_size n)
+{
+    char *arr = *(char **) pp;
+    pak__arr *head = pak_arr_header(arr);
+
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+    pak_arr_check(sz == head->elem_sz);
+    pak_assert(0 <= index && index <= head->count);
+    pak_assert(n >= 0 && n <= PAK_SIZE_MAX - head->count);
+
+    pak_assert(pak__arr_grow_to(pp, head->count + n) == 0);
+    arr = *(char **) pp;
+    head = pak_arr_header(arr);
+
+    memmove(arr + (index + n) * sz, arr + index * sz, (head->count - index) * sz);
+    memcpy(arr + index * sz, e, n * sz);
+    head->count += n;
+    PAK__ARR_NOTE(head, n, 0, 0, 0);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+PAK_PREFIX int pak__arr_erase_range(void **pp, pak_size index, pak_size n)
+{
+    char *arr = *(char **) pp;
+    pak__arr *head = pak_arr_header(arr);
+    size_t sz;
+
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+    pak_assert(n >= 0 && 0 <= index && index <= head->count - n);
+
+    sz = head->elem_sz;
+
+    pak__arr_destroy(arr, index, n);
+
+    memmove(arr + index * sz, arr + (index + n) * sz, (head->count - index - n) * sz);
+    head->count -= n;
+    PAK__ARR_NOTE(head, 0, n, 0, 0);
+
+    pak__arr_settle(pp);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+PAK_PREFIX int pak__arr_swap_remove(void **pp, pak_size index)
+{
+    char *arr = *(char **) pp;
+    pak__arr *head = pak_arr_header(arr);
+    size_t sz;
+
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+    pak_assert(0 <= index && index < head->count);
+
+    sz = head->elem_sz;
+
+    pak__arr_destroy(arr, index, 1);
+
+    if (index != head->count - 1)
+        memcpy(arr + index * sz, arr + (head->count - 1) * sz, sz);
+    head->count--;
+    PAK__ARR_NOTE(head, 0, 1, 0, 0);
+
+    pak__arr_settle(pp);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+#ifdef PAK_ARR_STATS
+/* Not thread safe, like the arrays themselves */
+static pak_arr_stats pak__arr_stats_total;
+static pak__arr_site *pak__arr_sites;
+
+static void pak__arr_stats_fold(pak_arr_stats *into, const pak_arr_stats *from)
+{
+    into->arrays += from->arrays;
+    into->resizes += from->resizes;
+    into->copied += from->copied;
+    into->pushes += from->pushes;
+    into->pops += from->pops;
+
+    if (from->peak_count > into->peak_count)
+        into->peak_count = from->peak_count;
+    if (from->peak_max > into->peak_max)
+        into->peak_max = from->peak_max;
+}
+
+PAK_PREFIX void pak__arr_stats_init(pak__arr *head)
+{
+    memset(&head->stats, 0, sizeof(head->stats));
+    head->site = NULL;
+
+    head->stats.arrays = 1;
+    head->stats.peak_max = head->max;
+    pak__arr_stats_fold(&pak__arr_stats_total, &head->stats);
+}
+
+PAK_PREFIX void *pak__arr_stats_site(void *arr, const char *file, int line)
+{
+    pak__arr *head = NULL;
+    pak__arr_site *site = NULL;
+
+    if (!arr)
+        return NULL;
+
+    head = pak_arr_header(arr);
+
+    for (site = pak__arr_sites; site; site = site->next)
+        if (site->line == line && strcmp(site->file, file) == 0)
+            break;
+
+    if (site && site == head->site)
+        return arr;
+
+    /* Typed arrays are tagged in their constructor first, a wrapper at the calling
+       line then moves them over */
+    if (head->site)
+        head->site->stats.arrays--;
+
+    /* Arrays still work without a site if this fails, they just are not listed */
+    if (!site) {
+        site = (pak__arr_site *)pak_calloc(1, sizeof(*site));
+        if (!site)
+            return arr;
+
+        site->file = file;
+        site->line = line;
+        site->next = pak__arr_sites;
+        pak__arr_sites = site;
+    }
+
+    head->site = site;
+    pak__arr_stats_fold(&site->stats, &head->stats);
+
+    return arr;
+}
+
+PAK_PREFIX void pak__arr_stats_note(pak__arr *head, unsigned long pushes, unsigned long pops,
+                                    unsigned long resizes, size_t copied)
+{
+    pak_arr_stats d;
+
+    memset(&d, 0, sizeof(d));
+    d.pushes = pushes;
+    d.pops = pops;
+    d.resizes = resizes;
+    d.copied = copied;
+    d.peak_count = head->count;
+    d.peak_max = head->max;
+
+    pak__arr_stats_fold(&head->stats, &d);
+    if (head->site)
+        pak__arr_stats_fold(&head->site->stats, &d);
+    pak__arr_stats_fold(&pak__arr_stats_total, &d);
+}
+
+PAK_PREFIX pak_arr_stats pak_arr_stats_get(void)
+{
+    return pak__arr_stats_total;
+}
+
+PAK_PREFIX void pak_arr_stats_reset(void)
+{
+    pak__arr_site *site;
+
+    memset(&pak__arr_stats_total, 0, sizeof(pak__arr_stats_total));
+    for (site = pak__arr_sites; site; site = site->next)
+        memset(&site->stats, 0, sizeof(site->stats));
+}
+
+PAK_PREFIX void pak_arr_stats_dump(FILE *f)
+{
+    const pak__arr_site *site;
+    const pak_arr_stats *s = &pak__arr_stats_total;
+
+    fprintf(f, "%-32s %8s %8s %12s %10s %10s %10s %10s\n", "site", "arrays", "resizes",
+            "copied", "pushes", "pops", "peak", "peak max");
+
+    for (site = pak__arr_sites; site; site = site->next) {
+        const pak_arr_stats *c = &site->stats;
+        char where[256];
+
+        /* Nothing happened here since the last reset */
+        if (!c->arrays && !c->pushes && !c->pops && !c->resizes)
+            continue;
+
+        sprintf(where, "%.200s:%d", site->file, site->line);
+        fprintf(f, "%-32s %8lu %8lu %12lu %10lu %10lu %10ld %10ld\n", where, c->arrays,
+                c->resizes, (unsigned long)c->copied, c->pushes, c->pops,
+                (long)c->peak_count, (long)c->peak_max);
+    }
+
+    fprintf(f, "%-32s %8lu %8lu %12lu %10lu %10lu %10ld %10ld\n", "total", s->arrays,
+            s->resizes, (unsigned long)s->copied, s->pushes, s->pops,
+            (long)s->peak_count, (long)s->peak_max);
+}
+#endif /* PAK_ARR_STATS */
+
+/* A chunk to qsort (when "b" is NULL) or two runs to merge into "out" */
+typedef struct {
+    char *a, *b, *out;
+    size_t na, nb, sz;
+    int (*cmp)(const void *, const void *);
+} pak__arr_sort_task;
+
+PAK_PREFIX void *pak__arr_sort_worker(void *p)
+{
+    pak__arr_sort_task *task = (pak__arr_sort_task *)p;
+    char *a = task->a, *b = task->b, *out = task->out;
+    size_t na = task->na, nb = task->nb, sz = task->sz;
+
+    if (!b) {
+        qsort(a, na, sz, task->cmp);
+        return NULL;
+    }
+
+    /* Ties are taken from "a" first, keeping the merge stable */
+    while (na && nb) {
+        if (task->cmp(b, a) < 0) {
+            memcpy(out, b, sz);
+            b += sz;
+            nb--;
+        } else {
+            memcpy(out, a, sz);
+            a += sz;
+            na--;
+        }
+
+        out += sz;
+    }
+
+    memcpy(out, a, na * sz);
+    memcpy(out + na * sz, b, nb * sz);
+
+    return NULL;
+}
+
+PAK_PREFIX void pak__arr_run_tasks(pak__arr_sort_task *tasks, int n)
+{
+#ifdef PAK__ARR_THREADS
+    pthread_t ids[PAK_ARR_MAX_THREADS];
+    pak_bool started[PAK_ARR_MAX_THREADS];
+    int i;
+
+    /* The calling thread takes the first task, and any that could not be started */
+    for (i = 1; i < n; i++)
+        started[i] = pthread_create(&ids[i], NULL, pak__arr_sort_worker, &tasks[i]) == 0;
+
+    pak__arr_sort_worker(&tasks[0]);
+
+    for (i = 1; i < n; i++) {
+        if (started[i])
+            pthread_join(ids[i], NULL);
+        else
+            pak__arr_sort_worker(&tasks[i]);
+    }
+#else
+    int i;
+
+    for (i = 0; i < n; i++)
+        pak__arr_sort_worker(&tasks[i]);
+#endif
+}
+
+/* How many of the first "k" elements of merging "a" and "b" come from "a" */
+PAK_PREFIX size_t pak__arr_corank(size_t k, const char *a, size_t na, const char *b, size_t nb,
+                                  size_t sz, int (*cmp)(const void *, const void *))
+{
+    size_t lo = (k > nb) ? k - nb : 0;
+    size_t hi = (k < na) ? k : na;
+
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+
+        if (cmp(a + i * sz, b + (k - i - 1) * sz) <= 0)
+            lo = i + 1;
+        else
+            hi = i;
+    }
+
+    return lo;
+}
+
+PAK_PREFIX int pak__arr_parallel_sort(void *arr, int (*cmp)(const void *, const void *), int threads)
+{
+    pak__arr *head = pak_arr_header(arr);
+    pak__arr_sort_task tasks[PAK_ARR_MAX_THREADS];
+    size_t bounds[PAK_ARR_MAX_THREADS + 1];
+    char *src, *dst, *tmp;
+    void *scratch = NULL;
+    size_t n, sz;
+    int runs, i, t;
+
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+
+    n = head->count;
+    sz = head->elem_sz;
+
+    if (threads > PAK_ARR_MAX_THREADS)
+        threads = PAK_ARR_MAX_THREADS;
+
+    if ((size_t)threads > n / PAK_ARR_PARALLEL_MIN)
+        threads = (int)(n / PAK_ARR_PARALLEL_MIN);
+
+    if (threads <= 1) {
+        qsort(arr, n, sz, cmp);
+        return 0;
+    }
+
+    scratch = pak__arr_new_ex(sz, (pak_size)n, NULL, pak_arr_growth_add(), head->align, head->alloc);
+    pak_assert(scratch);
+
+    /* Sort a chunk on every thread */
+    runs = threads;
+
+    for (i = 0; i <= runs; i++)
+        bounds[i] = n * i / runs;
+
+    for (i = 0; i < runs; i++) {
+        tasks[i].a = (char *)arr + bounds[i] * sz;
+        tasks[i].na = bounds[i + 1] - bounds[i];
+        tasks[i].b = NULL;
+        tasks[i].sz = sz;
+        tasks[i].cmp = cmp;
+    }
+
+    pak__arr_run_tasks(tasks, runs);
+
+    /* Merge pairs of runs until one is left, splitting every merge into even pieces
+       of output so that all the threads stay busy even for the last merge */
+    src = (char *)arr;
+    dst = (char *)scratch;
+
+    while (runs > 1) {
+        int pairs = (runs + 1) / 2;
+        int per = (threads / pairs > 0) ? threads / pairs : 1;
+        int count = 0;
+
+        for (i = 0; i < pairs; i++) {
+            size_t lo = bounds[2 * i];
+            size_t mid = bounds[(2 * i + 1 < runs) ? 2 * i + 1 : runs];
+            size_t hi = bounds[(2 * i + 2 < runs) ? 2 * i + 2 : runs];
+            size_t prev_k = 0, prev_i = 0;
+
+            for (t = 1; t <= per; t++) {
+                size_t k = (hi - lo) * t / per;
+                size_t ai = pak__arr_corank(k, src + lo * sz, mid - lo, src + mid * sz, hi - mid, sz, cmp);
+                pak__arr_sort_task *task = &tasks[count++];
+
+                task->a = src + (lo + prev_i) * sz;
+                task->na = ai - prev_i;
+                task->b = src + (mid + prev_k - prev_i) * sz;
+                task->nb = (k - ai) - (prev_k - prev_i);
+                task->out = dst + (lo + prev_k) * sz;
+                task->sz = sz;
+                task->cmp = cmp;
+
+                prev_k = k;
+                prev_i = ai;
+            }
+
+            bounds[i] = lo;
+        }
+
+        bounds[pairs] = n;
+        runs = pairs;
+
+        pak__arr_run_tasks(tasks, count);
+
+        tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != (char *)arr)
+        memcpy(arr, src, n * sz);
+
+    pak__arr_free(&scratch);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+/* LSD radix sort over unsigned keys, one byte at a time. Bytes which are the same for
+   every key are skipped, and the sorted keys always end up back in "keys". */
+#define PAK__ARR_RADIX(NAME, UTYPE)                                 \
+    PAK_PREFIX void NAME(UTYPE *keys, UTYPE *tmp, size_t n)         \
+    {                                                               \
+        size_t counts[256];                                         \
+        size_t shift, i;                                            \
+        UTYPE *src = keys;                                          \
+        UTYPE *dst = tmp;                                           \
+                                                                    \
+        for (shift = 0; shift < sizeof(UTYPE) * 8; shift += 8) {    \
+            size_t sum = 0;                                         \
+            UTYPE *swap;                                            \
+                                                                    \
+            memset(counts, 0, sizeof(counts));                      \
+                                                                    \
+            for (i = 0; i < n; i++)                                 \
+                counts[(src[i] >> shift) & 0xFF]++;                 \
+                                                                    \
+            if (counts[(src[0] >> shift) & 0xFF] == n)              \
+                continue;                                           \
+                                                                    \
+            for (i = 0; i < 256; i++) {                             \
+                size_t c = counts[i];                               \
+                counts[i] = sum;                                    \
+                sum += c;                                           \
+            }                                                       \
+                                                                    \
+            for (i = 0; i < n; i++)                                 \
+                dst[counts[(src[i] >> shift) & 0xFF]++] = src[i];   \
+                                                                    \
+            swap = src;                                             \
+            src = dst;                                              \
+            dst = swap;                                             \
+        }                                                           \
+                                                                    \
+        if (src != keys)                                            \
+            memcpy(keys, src, n * sizeof(UTYPE));                   \
+    }
+
+PAK__ARR_RADIX(pak__arr_radix32, uint32_t)
+PAK__ARR_RADIX(pak__arr_radix64, uint64_t)
+
+#undef PAK__ARR_RADIX
+
+/* Signed integers sort as unsigned ones with their sign bit flipped, and floats sort
+   as unsigned ones with every bit flipped if negative, or just the sign bit if not */
+#define PAK__ARR_RADIX_SORT(NAME, TYPE, UTYPE, RADIX, TO_KEY, FROM_KEY) \
+    PAK_PREFIX int NAME(TYPE *arr)                                  \
+    {                                                               \
+        pak__arr *head = pak_arr_header(arr);                       \
+        size_t i, n;                                                \
+        UTYPE *keys = NULL;                                         \
+                                                                    \
+        pak_arr_check(head->sig == PAK_ARR_SIGNATURE);              \
+                                                                    \
+        n = head->count;                                            \
+        if (n < 2)                                                  \
+            return 0;                                               \
+                                                                    \
+        keys = (UTYPE *)pak__alloc(head->alloc,                     \
+                                   2 * n * sizeof(*keys));          \
+        pak_assert(keys);                                           \
+                                                                    \
+        for (i = 0; i < n; i++) {                                   \
+            UTYPE k;                                                \
+            TO_KEY(arr[i], k);                                      \
+            keys[i] = k;                                            \
+        }                                                           \
+                                                                    \
+        RADIX(keys, keys + n, n);                                   \
+                                                                    \
+        for (i = 0; i < n; i++)                                     \
+            FROM_KEY(keys[i], arr[i]);                              \
+                                                                    \
+        pak__free(head->alloc, keys);                               \
+        return 0;                                                   \
+                                                                    \
+    fail:                                                           \
+        return -1;                                                  \
+    }
+
+#define PAK__INT_TO_KEY(V, K)   K = (uint32_t)(V) ^ 0x80000000u
+#define PAK__INT_FROM_KEY(K, V) V = (int)(K ^ 0x80000000u)
+#define PAK__LONG_TO_KEY(V, K)  K = (uint64_t)(V) ^ ((uint64_t)1 << 63)
+#define PAK__LONG_FROM_KEY(K, V) V = (long)(int64_t)(K ^ ((uint64_t)1 << 63))
+
+#define PAK__FLOAT_TO_KEY(V, K)                                     \
+    memcpy(&K, &V, sizeof(K));                                      \
+    K = (K & 0x80000000u) ? ~K : K | 0x80000000u
+#define PAK__FLOAT_FROM_KEY(K, V) {                                 \
+    uint32_t bits = (K & 0x80000000u) ? K & 0x7FFFFFFFu : ~K;       \
+    memcpy(&V, &bits, sizeof(V)); }
+
+#define PAK__DOUBLE_SIGN ((uint64_t)1 << 63)
+#define PAK__DOUBLE_TO_KEY(V, K)                                    \
+    memcpy(&K, &V, sizeof(K));                                      \
+    K = (K & PAK__DOUBLE_SIGN) ? ~K : K | PAK__DOUBLE_SIGN
+#define PAK__DOUBLE_FROM_KEY(K, V) {                                \
+    uint64_t bits = (K & PAK__DOUBLE_SIGN) ? K & ~PAK__DOUBLE_SIGN : ~K;\
+    memcpy(&V, &bits, sizeof(V)); }
+
+PAK__ARR_RADIX_SORT(pak_iarr_radix_sort, int,    uint32_t, pak__arr_radix32, PAK__INT_TO_KEY,    PAK__INT_FROM_KEY)
+PAK__ARR_RADIX_SORT(pak_larr_radix_sort, long,   uint64_t, pak__arr_radix64, PAK__LONG_TO_KEY,   PAK__LONG_FROM_KEY)
+PAK__ARR_RADIX_SORT(pak_farr_radix_sort, float,  uint32_t, pak__arr_radix32, PAK__FLOAT_TO_KEY,  PAK__FLOAT_FROM_KEY)
+PAK__ARR_RADIX_SORT(pak_darr_radix_sort, double, uint64_t, pak__arr_radix64, PAK__DOUBLE_TO_KEY, PAK__DOUBLE_FROM_KEY)
+
+#undef PAK__ARR_RADIX_SORT
+#undef PAK__INT_TO_KEY
+#undef PAK__INT_FROM_KEY
+#undef PAK__LONG_TO_KEY
+#undef PAK__LONG_FROM_KEY
+#undef PAK__FLOAT_TO_KEY
+#undef PAK__FLOAT_FROM_KEY
+#undef PAK__DOUBLE_SIGN
+#undef PAK__DOUBLE_TO_KEY
+#undef PAK__DOUBLE_FROM_KEY
+
+#endif /* PAK_IMPLEMENTATION */
+#endif /* PAK_NO_ARR */
+
+/*
+   End of PAK Array Library
+*/
+
+/*
+    The PAK Deque library
+
+    A double ended queue kept in a ring buffer, so pushing and popping at either
+    end is O(1) and never allocates once the deque is large enough. The buffer
+    is a PAK Array whose size is always a power of two, so wrapping around is a
+    single mask. When it fills up it doubles, and the shorter side of the wrap
+    is moved once to keep the elements in order.
+
+    You must initialize the deque via the PAK_INIT_DEQUE macro:
+
+        PAK_INIT_DEQUE(int_deque, int)
+
+    PAK_INIT_DEQUE will define the following:
+
+        <name>   <name>_new      (pak_size max);
+        <name>   <name>_new_alloc(pak_size max, const pak_allocator *alloc);
+        void     <name>_free     (<name> *pp);
+        pak_size <name>_count    (<name> dq);
+        pak_size <name>_max      (<name> dq);
+        void     <name>_clear    (<name> dq);
+        int      <name>_reserve  (<name> dq, pak_size max);
+        int      <name>_push     (<name> dq, <type> val); // To the back
+        int      <name>_unshift  (<name> dq, <type> val); // To the front
+        int      <name>_pop      (<name> dq, <type> *out); // From the back
+        int      <name>_shift    (<name> dq, <type> *out); // From the front
+        <type>  *<name>_get      (<name> dq, pak_size index);
+        <type>  *<name>_front    (<name> dq);
+        <type>  *<name>_back     (<name> dq);
+
+    "out" may be NULL when the removed element is not needed, and "<name>_get"
+    takes negative indices counting from the back, like "<name>_get" of PAK
+    Lists. Elements can also be indexed directly, front first, with
+    "pak_deque_at(dq, i)", which can be assigned to.
+
+    Example:
+
+        int_deque q = int_deque_new(64);
+        int i, job;
+
+        for (i = 0; i < 100; i++)
+            int_deque_push(q, i);
+
+        while (int_deque_count(q) > 0)
+            int_deque_shift(q, &job);
+
+        int_deque_free(&q);
+*/
+
+#ifndef PAK_NO_DEQUE
+
+#ifdef PAK_NO_ARR
+#   error "PAK Deque depends on PAK arrays"
+#endif
+
+/* Element "I" counting from the front, without a bounds check */
+#define pak_deque_at(D, I) ((D)->buf[((D)->head + (I)) & (D)->mask])
+
+#define PAK__INIT_DEQUE_TYPE(NAME, TYPE)                                            \
+    typedef struct {                                                                \
+        TYPE *buf; /* PAK Array, only its max is used */                            \
+        pak_size head;                                                              \
+        pak_size count;                                                             \
+        pak_size mask;                                                              \
+    } NAME##_;                                                                      \
+                                                                                    \
+    typedef NAME##_* NAME;
+
+/* For header files */
+#define PAK_INIT_DEQUE_PROTOTYPES(NAME, TYPE)                                       \
+    PAK__INIT_DEQUE_TYPE(NAME, TYPE)                                                \
+                                                                                    \
+    extern NAME NAME##_new_alloc(pak_size max, const pak_allocator *alloc);         \
+    extern NAME NAME##_new(pak_size max);                                           \
+    extern void NAME##_free(NAME *pp);                                              \
+    extern pak_size NAME##_count(NAME dq);                                          \
+    extern pak_size NAME##_max(NAME dq);                                            \
+    extern void NAME##_clear(NAME dq);                                              \
+    extern int NAME##_reserve(NAME dq, pak_size max);                               \
+    extern int NAME##_push(NAME dq, TYPE val);                                      \
+    extern int NAME##_unshift(NAME dq, TYPE val);                                   \
+    extern int NAME##_pop(NAME dq, TYPE *out);                                      \
+    extern int NAME##_shift(NAME dq, TYPE *out);                                    \
+    extern TYPE *NAME##_get(NAME dq, pak_size index);                               \
+    extern TYPE *NAME##_front(NAME dq);                                             \
+    extern TYPE *NAME##_back(NAME dq);
+
+#define PAK_INIT_DEQUE(NAME, TYPE)                                                  \
+    PAK__INIT_DEQUE_TYPE(NAME, TYPE)                                                \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new_alloc(pak_size max, const pak_allocator *alloc)      \
+    {                                                                               \
+        NAME dq = NULL;                                                             \
+        pak_size cap = 1;                                                           \
+                                                                                    \
+        pak_assert(max > 0 && max <= PAK_SIZE_MAX / 2 + 1);                         \
+                                                                                    \
+        while (cap < max)                                                           \
+            cap <<= 1;                                                              \
+                                                                                    \
+        dq = (NAME)pak__alloc(alloc, sizeof(*dq));                                  \
+        pak_assert(dq);                                                             \
+                                                                                    \
+        dq->buf = pak_arr_new_alloc(TYPE, cap, alloc);                              \
+        pak_assertp(dq->buf, pak__free(alloc, dq));                                 \
+                                                                                    \
+        dq->head = 0;                                                               \
+        dq->count = 0;                                                              \
+        dq->mask = cap - 1;                                                         \
+                                                                                    \
+        return dq;                                                                  \
+                                                                                    \
+    fail:                                                                           \
+        return NULL;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new(pak_size max)                                        \
+    {                                                                               \
+        return NAME##_new_alloc(max, NULL);                                         \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX void NAME##_free(NAME *pp)                                           \
+    {                                                                               \
+        NAME dq = *pp;                                                              \
+        const pak_allocator *alloc = NULL;                                          \
+                                                                                    \
+        pak_assert(dq); /* Double free? */                                          \
+                                                                                    \
+        alloc = pak_arr_header(dq->buf)->alloc;                                     \
+        pak_arr_free(&dq->buf);                                                     \
+        pak__free(alloc, dq);                                                       \
+                                                                                    \
+        *pp = NULL;                                                                 \
+                                                                                    \
+    fail:                                                                           \
+        return;                                                                     \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX pak_size NAME##_count(NAME dq) { return dq->count; }                 \
+    PAK_PREFIX pak_size NAME##_max(NAME dq)   { return dq->mask + 1; }              \
+    PAK_PREFIX void NAME##_clear(NAME dq) { dq->head = 0; dq->count = 0; }          \
+                                                                                    \
+    /* Resizes the ring once to the first power of two holding "max", then moves    \
+       whichever side of the wrap is shorter so the elements are contiguous again   \
+       (modulo the new size) */                                                     \
+    PAK_PREFIX int NAME##__grow(NAME dq, pak_size max)                              \
+    {                                                                               \
+        pak_size old = dq->mask + 1, size = old, wrapped;                           \
+                                                                                    \
+        pak_assert(max <= PAK_SIZE_MAX / 2 + 1);                                    \
+        while (size < max)                                                          \
+            size *= 2;                                                              \
+                                                                                    \
+        pak_assert(pak_arr_resize(&dq->buf, size) == 0);                            \
+                                                                                    \
+        /* The ring at least doubled, so neither move overlaps what it copies */    \
+        wrapped = dq->head + dq->count - old;                                       \
+        if (wrapped > 0) {                                                          \
+            if (wrapped <= old - dq->head) {                                        \
+                memcpy(dq->buf + old, dq->buf, wrapped * sizeof(TYPE));             \
+            } else {                                                                \
+                memcpy(dq->buf + dq->head + size - old, dq->buf + dq->head,         \
+                       (old - dq->head) * sizeof(TYPE));                            \
+                dq->head += size - old;                                             \
+            }                                                                       \
+        }                                                                           \
+                                                                                    \
+        dq->mask = size - 1;                                                        \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_reserve(NAME dq, pak_size max)                            \
+    {                                                                               \
+        return (max > dq->mask + 1) ? NAME##__grow(dq, max) : 0;                    \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_push(NAME dq, TYPE val)                                   \
+    {                                                                               \
+        if (dq->count > dq->mask)                                                   \
+            pak_assert(NAME##__grow(dq, dq->count + 1) == 0);                       \
+                                                                                    \
+        dq->buf[(dq->head + dq->count) & dq->mask] = val;                           \
+        dq->count++;                                                                \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_unshift(NAME dq, TYPE val)                                \
+    {                                                                               \
+        if (dq->count > dq->mask)                                                   \
+            pak_assert(NAME##__grow(dq, dq->count + 1) == 0);                       \
+                                                                                    \
+        dq->head = (dq->head - 1) & dq->mask;                                       \
+        dq->buf[dq->head] = val;                                                    \
+        dq->count++;                                                                \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    /* Removes the last element, storing it in "out" unless it is NULL */           \
+    PAK_PREFIX int NAME##_pop(NAME dq, TYPE *out)                                   \
+    {                                                                               \
+        pak_assert(dq->count > 0);                                                  \
+                                                                                    \
+        dq->count--;                                                                \
+        if (out)                                                                    \
+            *out = dq->buf[(dq->head + dq->count) & dq->mask];                      \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    /* Removes the first element, storing it in "out" unless it is NULL */          \
+    PAK_PREFIX int NAME##_shift(NAME dq, TYPE *out)                                 \
+    {                                                                               \
+        pak_assert(dq->count > 0);                                                  \
+                                                                                    \
+        if (out)                                                                    \
+            *out = dq->buf[dq->head];                                               \
+                                                                                    \
+        dq->head = (dq->head + 1) & dq->mask;                                       \
+        dq->count--;                                                                \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    /* Takes negative indices like <name>_get of PAK Lists, NULL if out of range */ \
+    PAK_PREFIX TYPE *NAME##_get(NAME dq, pak_size index)                            \
+    {                                                                               \
+        if (index < 0)                                                              \
+            index += dq->count;                                                     \
+                                                                                    \
+        pak_assert(0 <= index && index < dq->count);                                \
+        return &pak_deque_at(dq, index);                                            \
+                                                                                    \
+    fail:                                                                           \
+        return NULL;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX TYPE *NAME##_front(NAME dq) { return NAME##_get(dq, 0); }            \
+    PAK_PREFIX TYPE *NAME##_back(NAME dq)  { return NAME##_get(dq, -1); }
+
+#endif /* PAK_NO_DEQUE */
+
+/*
+    End of PAK Deque library
+*/
+
+/*
+    The PAK Segmented Array library
+
+    A growable array kept in fixed size chunks instead of one block, so growing
+    it allocates one more chunk and never moves or copies what is already there.
+    Pointers to elements stay valid for as long as the element is in the array,
+    and there are no realloc spikes once arrays get large. The chunks hold a
+    power of two elements each, so finding an element is a shift and a mask,
+    and the table of chunk pointers is a PAK Array.
+
+    You must initialize the segmented array via the PAK_INIT_SEGARR macro, with
+    the number of elements per chunk given as a power of two:
+
+        PAK_INIT_SEGARR(row_segarr, struct row, 12) // 4096 rows per chunk
+
+    PAK_INIT_SEGARR will define the following:
+
+        <name>   <name>_new          (pak_size max);
+        <name>   <name>_new_alloc    (pak_size max, const pak_allocator *alloc);
+        void     <name>_free         (<name> *pp);
+        pak_size <name>_count        (<name> seg);
+        pak_size <name>_max          (<name> seg);
+        void     <name>_clear        (<name> seg);
+        int      <name>_reserve      (<name> seg, pak_size max);
+        int      <name>_shrink_to_fit(<name> seg);
+        int      <name>_push         (<name> seg, <type> val);
+        int      <name>_pop          (<name> seg, <type> *out);
+        <type>  *<name>_get          (<name> seg, pak_size index);
+        <type>  *<name>_back         (<name> seg);
+
+    "out" may be NULL when the popped element is not needed, and "<name>_get"
+    takes negative indices counting from the back. Popping and clearing keep
+    the chunks around for the next pushes, "<name>_shrink_to_fit" gives the
+    unused ones back. Elements can also be indexed directly with
+    "pak_segarr_at(seg, i)", which can be assigned to.
+
+    Example:
+
+        row_segarr rows = row_segarr_new(0);
+        struct row *first;
+
+        row_segarr_push(rows, some_row);
+        first = row_segarr_get(rows, 0);
+
+        for (i = 0; i < 1000000; i++)
+            row_segarr_push(rows, some_row); // "first" is still valid
+
+        row_segarr_free(&rows);
+*/
+
+#ifndef PAK_NO_SEGARR
+
+#ifdef PAK_NO_ARR
+#   error "PAK Segmented Arrays depend on PAK arrays"
+#endif
+
+/* Element "I", without a bounds check */
+#define pak_segarr_at(S, I) ((S)->chunks[(I) >> (S)->shift][(I) & (S)->mask])
+
+#define PAK__INIT_SEGARR_TYPE(NAME, TYPE)                                           \
+    typedef struct {                                                                \
+        TYPE **chunks; /* PAK Array of chunk pointers */                            \
+        pak_size count;                                                             \
+        pak_size mask;                                                              \
+        int shift;                                                                  \
+        const pak_allocator *alloc;                                                 \
+    } NAME##_;                                                                      \
+                                                                                    \
+    typedef NAME##_* NAME;
+
+/* For header files */
+#define PAK_INIT_SEGARR_PROTOTYPES(NAME, TYPE)                                      \
+    PAK__INIT_SEGARR_TYPE(NAME, TYPE)                                               \
+                                                                                    \
+    extern NAME NAME##_new_alloc(pak_size max, const pak_allocator *alloc);         \
+    extern NAME NAME##_new(pak_size max);                                           \
+    extern void NAME##_free(NAME *pp);                                              \
+    extern pak_size NAME##_count(NAME seg);                                         \
+    extern pak_size NAME##_max(NAME seg);                                           \
+    extern void NAME##_clear(NAME seg);                                             \
+    extern int NAME##_reserve(NAME seg, pak_size max);                              \
+    extern int NAME##_shrink_to_fit(NAME seg);                                      \
+    extern int NAME##_push(NAME seg, TYPE val);                                     \
+    extern int NAME##_pop(NAME seg, TYPE *out);                                     \
+    extern TYPE *NAME##_get(NAME seg, pak_size index);                              \
+    extern TYPE *NAME##_back(NAME seg);
+
+#define PAK_INIT_SEGARR(NAME, TYPE, CHUNK_BITS)                                     \
+    PAK__INIT_SEGARR_TYPE(NAME, TYPE)                                               \
+                                                                                    \
+    PAK_PREFIX void NAME##_free(NAME *pp)                                           \
+    {                                                                               \
+        NAME seg = *pp;                                                             \
+        pak_size i;                                                                 \
+                                                                                    \
+        pak_assert(seg); /* Double free? */                                         \
+                                                                                    \
+        for (i = 0; i < pak_arr_count(seg->chunks); i++)                            \
+            pak__free(seg->alloc, seg->chunks[i]);                                  \
+                                                                                    \
+        pak_arr_free(&seg->chunks);                                                 \
+        pak__free(seg->alloc, seg);                                                 \
+                                                                                    \
+        *pp = NULL;                                                                 \
+                                                                                    \
+    fail:                                                                           \
+        return;                                                                     \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX pak_size NAME##_count(NAME seg) { return seg->count; }               \
+    PAK_PREFIX void NAME##_clear(NAME seg)     { seg->count = 0; }                  \
+                                                                                    \
+    PAK_PREFIX pak_size NAME##_max(NAME seg)                                        \
+    {                                                                               \
+        return pak_arr_count(seg->chunks) << CHUNK_BITS;                            \
+    }                                                                               \
+                                                                                    \
+    /* Only ever adds chunks, the ones already there never move */                  \
+    PAK_PREFIX int NAME##_reserve(NAME seg, pak_size max)                           \
+    {                                                                               \
+        pak_size need;                                                              \
+                                                                                    \
+        pak_assert(max >= 0);                                                       \
+        if (max == 0)                                                               \
+            return 0;                                                               \
+                                                                                    \
+        need = ((max - 1) >> CHUNK_BITS) + 1;                                       \
+                                                                                    \
+        while (pak_arr_count(seg->chunks) < need) {                                 \
+            TYPE *chunk = (TYPE *)pak__alloc(seg->alloc,                            \
+                                             sizeof(TYPE) << CHUNK_BITS);           \
+            pak_assert(chunk);                                                      \
+            pak_assertp(pak_arr_push(&seg->chunks, chunk) == 0,                     \
+                        pak__free(seg->alloc, chunk));                              \
+        }                                                                           \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new_alloc(pak_size max, const pak_allocator *alloc)      \
+    {                                                                               \
+        NAME seg = NULL;                                                            \
+                                                                                    \
+        pak_assert(CHUNK_BITS > 0 && CHUNK_BITS < 8 * (int)sizeof(pak_size) - 1);   \
+                                                                                    \
+        seg = (NAME)pak__alloc(alloc, sizeof(*seg));                                \
+        pak_assert(seg);                                                            \
+                                                                                    \
+        seg->chunks = (TYPE **)pak__arr_new_ex(sizeof(TYPE *), 16, NULL,            \
+                pak_arr_growth_mul(2.0f), 0, alloc);                                \
+        pak_assertp(seg->chunks, pak__free(alloc, seg));                            \
+                                                                                    \
+        seg->count = 0;                                                             \
+        seg->mask = ((pak_size)1 << CHUNK_BITS) - 1;                                \
+        seg->shift = CHUNK_BITS;                                                    \
+        seg->alloc = alloc;                                                         \
+                                                                                    \
+        pak_assertp(NAME##_reserve(seg, max) == 0, NAME##_free(&seg));              \
+                                                                                    \
+        return seg;                                                                 \
+                                                                                    \
+    fail:                                                                           \
+        return NULL;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX NAME NAME##_new(pak_size max)                                        \
+    {                                                                               \
+        return NAME##_new_alloc(max, NULL);                                         \
+    }                                                                               \
+                                                                                    \
+    /* Frees the chunks past the last element, keeping at least one */              \
+    PAK_PREFIX int NAME##_shrink_to_fit(NAME seg)                                   \
+    {                                                                               \
+        pak_size keep = (seg->count > 0) ? ((seg->count - 1) >> CHUNK_BITS) + 1 : 1;\
+                                                                                    \
+        while (pak_arr_count(seg->chunks) > keep) {                                 \
+            pak__free(seg->alloc, seg->chunks[pak_arr_count(seg->chunks) - 1]);     \
+            pak_arr_count(seg->chunks)--;                                           \
+        }                                                                           \
+                                                                                    \
+        return pak_arr_shrink_to_fit(&seg->chunks);                                 \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_push(NAME seg, TYPE val)                                  \
+    {                                                                               \
+        if ((seg->count & seg->mask) == 0)                                          \
+            pak_assert(seg->count < PAK_SIZE_MAX &&                                 \
+                       NAME##_reserve(seg, seg->count + 1) == 0);                   \
+                                                                                    \
+        pak_segarr_at(seg, seg->count) = val;                                       \
+        seg->count++;                                                               \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX int NAME##_pop(NAME seg, TYPE *out)                                  \
+    {                                                                               \
+        pak_assert(seg->count > 0);                                                 \
+                                                                                    \
+        seg->count--;                                                               \
+        if (out)                                                                    \
+            *out = pak_segarr_at(seg, seg->count);                                  \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    /* Takes negative indices like <name>_get of PAK Lists, NULL if out of range */ \
+    PAK_PREFIX TYPE *NAME##_get(NAME seg, pak_size index)                           \
+    {                                                                               \
+        if (index < 0)                                                              \
+            index += seg->count;                                                    \
+                                                                                    \
+        pak_assert(0 <= index && index < seg->count);                               \
+        return &pak_segarr_at(seg, index);                                          \
+                                                                                    \
+    fail:                                                                           \
+        return NULL;                                                                \
+    }                                                                               \
+                                                                                    \
+    PAK_PREFIX TYPE *NAME##_back(NAME seg) { return NAME##_get(seg, -1); }
+
+#endif /* PAK_NO_SEGARR */
+
+/*
+    End of PAK Segmented Array library
+*/
+
+/*
+    The PAK Bit Array library
+
+    A fixed size array of bits packed 64 to a word, for flags and filter masks
+    that would take 8 times the memory as a "pak_carr" of bytes. The words live
+    in a PAK Array, so they go through the same allocators. Set operations
+    between bit arrays work a whole word at a time, and counting and searching
+    use the compiler's popcount and count trailing zeros builtins, which become
+    single instructions when the target has them (e.g. "-mpopcnt" on x86).
+
+        pak_bits pak_bits_new           (pak_size count);
+        pak_bits pak_bits_new_alloc     (pak_size count, const pak_allocator *alloc);
+        void     pak_bits_free          (pak_bits *pp);
+        pak_size pak_bits_size          (pak_bits bits);
+        int      pak_bits_resize        (pak_bits bits, pak_size count);
+        void     pak_bits_fill          (pak_bits bits, int val);
+
+        void     pak_bits_set           (pak_bits bits, pak_size i);
+        void     pak_bits_clear         (pak_bits bits, pak_size i);
+        int      pak_bits_test          (pak_bits bits, pak_size i);
+
+        int      pak_bits_and           (pak_bits dst, pak_bits src); // dst &= src
+        int      pak_bits_or            (pak_bits dst, pak_bits src); // dst |= src
+        int      pak_bits_xor           (pak_bits dst, pak_bits src); // dst ^= src
+        int      pak_bits_andnot        (pak_bits dst, pak_bits src); // dst &= ~src
+
+        pak_size pak_bits_count         (pak_bits bits);              // Bits set
+        pak_size pak_bits_rank          (pak_bits bits, pak_size i);  // Bits set below i
+        pak_size pak_bits_find_next_set (pak_bits bits, pak_size i);  // First set from i
+
+    New bits start cleared. "pak_bits_set", "pak_bits_clear" and "pak_bits_test"
+    are inline and do not check bounds. The set operations fail if the two bit
+    arrays are not the same size, and "pak_bits_find_next_set" returns -1 once
+    there are no set bits left.
+
+    Example:
+
+        pak_bits hot = pak_bits_new(1000000);
+        pak_size i;
+
+        pak_bits_set(hot, 42);
+        pak_bits_set(hot, 4242);
+
+        for (i = pak_bits_find_next_set(hot, 0); i >= 0; i = pak_bits_find_next_set(hot, i + 1))
+            printf("%ld\n", (long)i);
+
+        pak_bits_free(&hot);
+*/
+
+#ifndef PAK_NO_BITS
+
+#ifdef PAK_NO_ARR
+#   error "PAK Bits depend on PAK arrays"
 #endif
+
+typedef uint64_t pak_bits_word;
+
+#define PAK_BITS_WORD 64
+
+typedef struct {
+    pak_bits_word *words; /* PAK Array, its count is the number of words in use */
+    pak_size count;       /* Bits */
+} pak_bits_;
+
+typedef pak_bits_ *pak_bits;
+
+#if defined(__GNUC__) || defined(__clang__)
+#   define pak__popcount64(W) __builtin_popcountll(W)
+#   define pak__ctz64(W)      __builtin_ctzll(W)
+#else
+PAK_INLINE int pak__popcount64(pak_bits_word w)
+{
+    w = w - ((w >> 1) & 0x5555555555555555ull);
+    w = (w & 0x3333333333333333ull) + ((w >> 2) & 0x3333333333333333ull);
+    w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (int)((w * 0x0101010101010101ull) >> 56);
+}
+
+/* "w" must not be zero */
+PAK_INLINE int pak__ctz64(pak_bits_word w)
+{
+    return pak__popcount64((w & (~w + 1)) - 1);
+}
 #endif
 
-/* Begin function definitions */
-#ifdef PAK_IMPLEMENTATION
+PAK_INLINE void pak_bits_set(pak_bits bits, pak_size i)
+{
+    bits->words[i / PAK_BITS_WORD] |= (pak_bits_word)1 << (i % PAK_BITS_WORD);
+}
 
-PAK_PREFIX void *pak__arr_new(size_t sz, int max)
+PAK_INLINE void pak_bits_clear(pak_bits bits, pak_size i)
 {
-    pak__arr *arr = NULL;
-    pak__arr *head = NULL;
+    bits->words[i / PAK_BITS_WORD] &= ~((pak_bits_word)1 << (i % PAK_BITS_WORD));
+}
 
-    pak_assert(max > 0);
+PAK_INLINE int pak_bits_test(pak_bits bits, pak_size i)
+{
+    return (int)((bits->words[i / PAK_BITS_WORD] >> (i % PAK_BITS_WORD)) & 1);
+}
 
-    arr = (pak__arr *)pak_malloc(sizeof(*arr) + (sz * max));
-    pak_assert(arr);
+PAK_PREFIX pak_bits pak_bits_new(pak_size count);
+PAK_PREFIX pak_bits pak_bits_new_alloc(pak_size count, const pak_allocator *alloc);
+PAK_PREFIX void pak_bits_free(pak_bits *pp);
+PAK_PREFIX pak_size pak_bits_size(pak_bits bits);
+PAK_PREFIX int pak_bits_resize(pak_bits bits, pak_size count);
+PAK_PREFIX void pak_bits_fill(pak_bits bits, int val);
 
-    arr++;
-    head = pak_arr_header(arr);
+PAK_PREFIX int pak_bits_and(pak_bits dst, pak_bits src);
+PAK_PREFIX int pak_bits_or(pak_bits dst, pak_bits src);
+PAK_PREFIX int pak_bits_xor(pak_bits dst, pak_bits src);
+PAK_PREFIX int pak_bits_andnot(pak_bits dst, pak_bits src);
 
-    head->count = 0;
-    head->max = max;
-    head->rate = max;
-    head->elem_sz = sz;
-    head->sig = PAK_ARR_SIGNATURE;
-    head->gc = NULL;
+PAK_PREFIX pak_size pak_bits_count(pak_bits bits);
+PAK_PREFIX pak_size pak_bits_rank(pak_bits bits, pak_size i);
+PAK_PREFIX pak_size pak_bits_find_next_set(pak_bits bits, pak_size i);
 
-    return arr;
+#ifdef PAK_IMPLEMENTATION
 
-fail:
-    return NULL;
+/* Words needed for "N" bits, without overflowing near PAK_SIZE_MAX */
+#define pak__bits_words(N) ((N) / PAK_BITS_WORD + ((N) % PAK_BITS_WORD != 0))
+
+/* Bits past the count in the last word are always kept cleared, so that whole
+   words can be counted and searched */
+PAK_PREFIX void pak__bits_trim(pak_bits bits)
+{
+    pak_size rem = bits->count % PAK_BITS_WORD;
+
+    if (rem)
+        bits->words[bits->count / PAK_BITS_WORD] &= ((pak_bits_word)1 << rem) - 1;
 }
 
-PAK_PREFIX void *pak__arr_new_gc(size_t sz, int max, pak__arr_gc gc)
+PAK_PREFIX pak_bits pak_bits_new_alloc(pak_size count, const pak_allocator *alloc)
 {
-    void *arr = pak__arr_new(sz, max);
-    pak_assert(arr);
+    pak_bits bits = NULL;
+    pak_size n = pak__bits_words(count);
 
-    pak_arr_header(arr)->gc = gc;
+    pak_assert(count >= 0);
 
-    return arr;
+    bits = (pak_bits)pak__alloc(alloc, sizeof(*bits));
+    pak_assert(bits);
+
+    bits->words = pak_arr_new_alloc(pak_bits_word, n > 0 ? n : 1, alloc);
+    pak_assertp(bits->words, pak__free(alloc, bits));
+
+    memset(bits->words, 0, n * sizeof(pak_bits_word));
+    pak_arr_count(bits->words) = n;
+    bits->count = count;
+
+    return bits;
 
 fail:
     return NULL;
 }
 
-PAK_PREFIX void pak__arr_free(void **pp)
+PAK_PREFIX pak_bits pak_bits_new(pak_size count)
 {
-    void *arr = *pp;
-    pak__arr *head = NULL;
+    return pak_bits_new_alloc(count, NULL);
+}
 
-    pak_assert(arr); /* Double free? */
+PAK_PREFIX void pak_bits_free(pak_bits *pp)
+{
+    pak_bits bits = *pp;
+    const pak_allocator *alloc = NULL;
 
-    head = pak_arr_header(arr);
-    pak_assert(head->sig == PAK_ARR_SIGNATURE);
+    pak_assert(bits); /* Double free? */
 
-    while(head->gc && --head->count > 0)
-        head->gc(pak_arr_notype_last(arr));
+    alloc = pak_arr_header(bits->words)->alloc;
+    pak_arr_free(&bits->words);
+    pak__free(alloc, bits);
 
-    pak_free(head);
     *pp = NULL;
 
 fail:
     return;
 }
 
-PAK_PREFIX int pak__arr_resize(void **pp, int max)
+PAK_PREFIX pak_size pak_bits_size(pak_bits bits)
 {
-    pak__arr *arr = NULL;
-    pak__arr *head = NULL;
-    pak__arr *new_head = NULL;
-
-    pak_assert(max > 0);
-
-    arr = *(pak__arr **) pp;
-    head = pak_arr_header(arr);
-
-    pak_assert(head->sig == PAK_ARR_SIGNATURE);
+    return bits->count;
+}
 
-    if (max < head->count) {
-        while (head->gc && --head->count > max)
-            head->gc(pak_arr_notype_last(arr));
+PAK_PREFIX int pak_bits_resize(pak_bits bits, pak_size count)
+{
+    pak_size n = pak__bits_words(count);
+    pak_size old = pak_arr_count(bits->words);
 
-        head->count = max;
-    }
+    pak_assert(count >= 0);
 
-    head->max = max;
+    if (n > pak_arr_max(bits->words))
+        pak_assert(pak_arr_resize(&bits->words, n) == 0);
 
-    new_head = (pak__arr *)pak_realloc(head, sizeof(*new_head) + (head->elem_sz * max));
-    pak_assert(new_head);
+    if (n > old)
+        memset(bits->words + old, 0, (n - old) * sizeof(pak_bits_word));
 
-    *pp = new_head + 1;
+    pak_arr_count(bits->words) = n;
+    bits->count = count;
+    pak__bits_trim(bits);
 
     return 0;
 
@@ -878,70 +4958,96 @@ fail:
     return -1;
 }
 
-PAK_PREFIX int pak__arr_expand(void **pp)
-{
-    pak__arr *head = pak_arr_header(*pp);
-    return pak__arr_resize(pp, head->max + head->rate);
-}
-
-PAK_PREFIX int pak__arr_contract(void **pp)
+PAK_PREFIX void pak_bits_fill(pak_bits bits, int val)
 {
-    pak__arr *head = pak_arr_header(*pp);
-    return pak__arr_resize(pp, head->max - head->rate);
+    memset(bits->words, val ? 0xFF : 0, pak_arr_count(bits->words) * sizeof(pak_bits_word));
+    pak__bits_trim(bits);
 }
 
-PAK_PREFIX int pak__arr_push(void **pp, size_t sz, void *e)
-{
-    pak__arr *arr = *(pak__arr **) pp;
-    pak__arr *head = pak_arr_header(arr);
-
-    pak_assert(head->sig == PAK_ARR_SIGNATURE);
-    pak_assert(sz == head->elem_sz)
-
-    if (head->count >= head->max) {
-        pak_assert(pak_arr_expand(pp) == 0);
-        arr = *(pak__arr **) pp;
-        head = pak_arr_header(arr);
+/* Plain loops over whole words, which compilers vectorize */
+#define PAK__BITS_OP(NAME, EXPR)                                                    \
+    PAK_PREFIX int NAME(pak_bits dst, pak_bits src)                                 \
+    {                                                                               \
+        pak_bits_word *d = dst->words;                                              \
+        const pak_bits_word *s = src->words;                                        \
+        pak_size i, n = pak_arr_count(d);                                           \
+                                                                                    \
+        pak_assert(dst->count == src->count);                                       \
+                                                                                    \
+        for (i = 0; i < n; i++)                                                     \
+            d[i] = EXPR;                                                            \
+                                                                                    \
+        return 0;                                                                   \
+                                                                                    \
+    fail:                                                                           \
+        return -1;                                                                  \
     }
 
-    head->count++;
+PAK__BITS_OP(pak_bits_and,    d[i] & s[i])
+PAK__BITS_OP(pak_bits_or,     d[i] | s[i])
+PAK__BITS_OP(pak_bits_xor,    d[i] ^ s[i])
+PAK__BITS_OP(pak_bits_andnot, d[i] & ~s[i])
 
-    memcpy(pak_arr_notype_last(arr), e, sz);
+#undef PAK__BITS_OP
 
-    return 0;
+PAK_PREFIX pak_size pak_bits_count(pak_bits bits)
+{
+    pak_size i, n = pak_arr_count(bits->words), set = 0;
 
-fail:
-    return -1;
+    for (i = 0; i < n; i++)
+        set += pak__popcount64(bits->words[i]);
+
+    return set;
 }
 
-PAK_PREFIX int pak__arr_pop(void **pp)
+PAK_PREFIX pak_size pak_bits_rank(pak_bits bits, pak_size i)
 {
-    pak__arr *head = pak_arr_header(*pp);
-    pak_assert(head->sig == PAK_ARR_SIGNATURE);
+    pak_size w, set = 0;
 
-    if (head->count > 0) {
-        if (head->gc)
-            head->gc(pak_arr_notype_last(*pp));
+    if (i <= 0)
+        return 0;
+    if (i > bits->count)
+        i = bits->count;
 
-        head->count--;
+    for (w = 0; w < i / PAK_BITS_WORD; w++)
+        set += pak__popcount64(bits->words[w]);
 
-        if (head->count < head->max - head->rate) {
-            pak__arr_contract(pp);
-            head = pak_arr_header(*pp);
-        }
+    if (i % PAK_BITS_WORD)
+        set += pak__popcount64(bits->words[w] & (((pak_bits_word)1 << (i % PAK_BITS_WORD)) - 1));
+
+    return set;
+}
+
+PAK_PREFIX pak_size pak_bits_find_next_set(pak_bits bits, pak_size i)
+{
+    pak_size w, n = pak_arr_count(bits->words);
+    pak_bits_word word;
+
+    if (i < 0)
+        i = 0;
+    if (i >= bits->count)
+        return -1;
+
+    /* Mask off the bits below "i" in the first word, then skip empty words */
+    w = i / PAK_BITS_WORD;
+    word = bits->words[w] & (~(pak_bits_word)0 << (i % PAK_BITS_WORD));
+
+    while (!word) {
+        if (++w >= n)
+            return -1;
+        word = bits->words[w];
     }
 
-    return 0;
-        
-fail:
-    return -1;
+    return w * PAK_BITS_WORD + pak__ctz64(word);
 }
 
+#undef pak__bits_words
+
 #endif /* PAK_IMPLEMENTATION */
-#endif /* PAK_NO_ARR */
+#endif /* PAK_NO_BITS */
 
 /*
-   End of PAK Array Library
+    End of PAK Bit Array library
 */
 
 /*
@@ -1087,32 +5193,38 @@ fail:
     } NAME##_pair;                                              \
                                                                 \
     typedef struct {                                            \
-        unsigned int max;                                       \
-        unsigned int rate;                                      \
-        unsigned int busy;                                      \
+        pak_size max;                                           \
+        pak_size rate;                                          \
+        pak_size busy;                                          \
         NAME##_pair **buckets;                                  \
+        const pak_allocator *alloc;                             \
     } NAME##_;                                                  \
                                                                 \
     typedef NAME##_* NAME;                                      \
                                                                 \
-    unsigned int NAME##_busy(NAME dict)  { return dict->busy; } \
-    unsigned int NAME##_max(NAME dict)   { return dict->max;  } \
-    unsigned int NAME##_rate(NAME dict)  { return dict->rate; } \
+    pak_size NAME##_busy(NAME dict)  { return dict->busy; }     \
+    pak_size NAME##_max(NAME dict)   { return dict->max;  }     \
+    pak_size NAME##_rate(NAME dict)  { return dict->rate; }     \
                                                                 \
-    NAME NAME##_new(unsigned int sz)                            \
+    NAME NAME##_new_alloc(pak_size sz,                          \
+                          const pak_allocator *alloc)           \
     {                                                           \
         NAME dict = NULL;                                       \
                                                                 \
-        dict = (NAME)pak_malloc(sizeof(*dict));                 \
+        pak_assert(sz > 0 && (size_t)sz <=                      \
+                   (size_t)-1 / sizeof(*dict->buckets));        \
+                                                                \
+        dict = (NAME)pak__alloc(alloc, sizeof(*dict));          \
         pak_assert(dict);                                       \
                                                                 \
-        dict->buckets = (NAME##_pair **)pak_malloc(             \
+        dict->buckets = (NAME##_pair **)pak__alloc(alloc,       \
                 sizeof(*dict->buckets) * sz);                   \
         pak_assert(dict->buckets);                              \
                                                                 \
         dict->busy = 0;                                         \
         dict->max = sz;                                         \
         dict->rate = sz;                                        \
+        dict->alloc = alloc;                                    \
                                                                 \
         memset(dict->buckets, (int)NULL,                        \
                 sizeof(*dict->buckets) * sz);                   \
@@ -1121,11 +5233,16 @@ fail:
                                                                 \
     fail:                                                       \
         if (dict)                                               \
-            pak_free(dict);                                     \
+            pak__free(alloc, dict);                             \
                                                                 \
         return NULL;                                            \
     }                                                           \
                                                                 \
+    NAME NAME##_new(pak_size sz)                                \
+    {                                                           \
+        return NAME##_new_alloc(sz, NULL);                      \
+    }                                                           \
+                                                                \
     void NAME##_free(NAME *pp)                                  \
     {                                                           \
         NAME dict = *pp;                                        \
@@ -1133,7 +5250,7 @@ fail:
         pak_assert(dict); /* Double free? */                    \
                                                                 \
         if (dict->busy != 0) {                                  \
-            unsigned int i;                                     \
+            pak_size i;                                         \
             for (i = 0; i < dict->max; i++) {                   \
                 NAME##_pair *curr = dict->buckets[i];           \
                 while (curr) {                                  \
@@ -1141,7 +5258,7 @@ fail:
                                                                 \
                     KEY_FREE(curr->key);                        \
                     VAL_FREE(curr->val);                        \
-                    pak_free(curr);                             \
+                    pak__free(dict->alloc, curr);               \
                                                                 \
                     dict->buckets[i] = tmp;                     \
                     curr = tmp;                                 \
@@ -1149,7 +5266,8 @@ fail:
             }                                                   \
         }                                                       \
                                                                 \
-        pak_free(dict);                                         \
+        pak__free(dict->alloc, dict->buckets);                  \
+        pak__free(dict->alloc, dict);                           \
         *pp = NULL;                                             \
                                                                 \
     fail:                                                       \
@@ -1159,7 +5277,7 @@ fail:
     /* Interal! */                                              \
     int NAME##__insert_raw(NAME dict, NAME##_pair *pair)        \
     {                                                           \
-        unsigned int loc;                                       \
+        pak_size loc;                                           \
                                                                 \
         loc = HASH(KEY_ACCESS(pair->key),                       \
                    KEY_COUNT(pair->key)) % dict->max;           \
@@ -1187,14 +5305,14 @@ fail:
         return -1;                                              \
     }                                                           \
                                                                 \
-    int NAME##_resize(NAME dict, unsigned int remax)            \
+    int NAME##_resize(NAME dict, pak_size remax)                \
     {                                                           \
         NAME tmp_dict = NULL;                                   \
-        unsigned int i;                                         \
+        pak_size i;                                             \
                                                                 \
         pak_assert(remax >= dict->rate);                        \
                                                                 \
-        tmp_dict = NAME##_new(remax);                           \
+        tmp_dict = NAME##_new_alloc(remax, dict->alloc);        \
         pak_assert(tmp_dict);                                   \
                                                                 \
         for (i = 0; i < dict->max; i++) {                       \
@@ -1213,13 +5331,13 @@ fail:
             }                                                   \
         }                                                       \
                                                                 \
-        pak_free(dict->buckets);                                \
+        pak__free(dict->alloc, dict->buckets);                  \
                                                                 \
         dict->buckets = tmp_dict->buckets;                      \
         dict->max     = tmp_dict->max;                          \
         dict->busy    = tmp_dict->busy;                         \
                                                                 \
-        pak_free(tmp_dict);                                     \
+        pak__free(dict->alloc, tmp_dict);                       \
                                                                 \
         return 0;                                               \
                                                                 \
@@ -1227,8 +5345,8 @@ fail:
         /* Do a raw free, since we don't want already copied */ \
         /* data to be free'd as it remains in the old dict.  */ \
         if (tmp_dict) {                                         \
-            pak_free(tmp_dict->buckets);                        \
-            pak_free(tmp_dict);                                 \
+            pak__free(dict->alloc, tmp_dict->buckets);          \
+            pak__free(dict->alloc, tmp_dict);                   \
         }                                                       \
                                                                 \
         return -1;                                              \
@@ -1240,7 +5358,8 @@ fail:
         pak_bool key_alloced = PAK_FALSE;                       \
         pak_bool val_alloced = PAK_FALSE;                       \
                                                                 \
-        pair = (NAME##_pair *)pak_malloc(sizeof(*pair));        \
+        pair = (NAME##_pair *)pak__alloc(dict->alloc,           \
+                                         sizeof(*pair));        \
         pak_assert(pair);                                       \
                                                                 \
         pair->key = KEY_COPY(key);                              \
@@ -1256,7 +5375,8 @@ fail:
         pair->next = NULL;                                      \
                                                                 \
         if (dict->busy >= dict->max)                            \
-            pak_assert(NAME##_resize(dict,                      \
+            pak_assert(dict->rate <= PAK_SIZE_MAX - dict->max &&\
+                       NAME##_resize(dict,                      \
                         dict->max + dict->rate) == 0);          \
                                                                 \
         return NAME##__insert_raw(dict, pair);                  \
@@ -1268,7 +5388,7 @@ fail:
             if (val_alloced)                                    \
                 VAL_FREE(pair->key);                            \
                                                                 \
-            pak_free(pair);                                     \
+            pak__free(dict->alloc, pair);                       \
         }                                                       \
                                                                 \
         return -1;                                              \
@@ -1276,7 +5396,7 @@ fail:
                                                                 \
     void NAME##_remove(NAME dict, KEY_PARAM_TYPE key)           \
     {                                                           \
-        unsigned int loc;                                       \
+        pak_size loc;                                           \
         KEY_TYPE cpy;                                           \
         NAME##_pair *curr = NULL;                               \
         NAME##_pair *prev = NULL;                               \
@@ -1297,7 +5417,7 @@ fail:
                 KEY_FREE(curr->key);                            \
                 VAL_FREE(curr->val);                            \
                                                                 \
-                pak_free(curr);                                 \
+                pak__free(dict->alloc, curr);                   \
                                                                 \
                 if (prev)                                       \
                     prev->next = tmp;                           \
@@ -1323,7 +5443,7 @@ fail:
                                                                 \
     NAME##_pair *NAME##_get(NAME dict, KEY_PARAM_TYPE key)      \
     {                                                           \
-        unsigned int loc;                                       \
+        pak_size loc;                                           \
         KEY_TYPE cpy;                                           \
         NAME##_pair *curr = NULL;                               \
                                                                 \
@@ -1378,19 +5498,21 @@ fail:
     } NAME##_pair;                                                                \
                                                                                   \
     typedef struct {                                                              \
-        unsigned int max;                                                         \
-        unsigned int rate;                                                        \
-        unsigned int busy;                                                        \
+        pak_size max;                                                             \
+        pak_size rate;                                                            \
+        pak_size busy;                                                            \
         NAME##_pair **buckets;                                                    \
+        const pak_allocator *alloc;                                               \
     } NAME##_;                                                                    \
                                                                                   \
     typedef NAME##_* NAME;                                                        \
                                                                                   \
-    extern unsigned int NAME##_busy(NAME dict);                                   \
-    extern unsigned int NAME##_max(NAME dict);                                    \
-    extern unsigned int NAME##_rate(NAME dict);                                   \
+    extern pak_size NAME##_busy(NAME dict);                                       \
+    extern pak_size NAME##_max(NAME dict);                                        \
+    extern pak_size NAME##_rate(NAME dict);                                       \
                                                                                   \
-    extern NAME NAME##_new(unsigned int sz)                                       \
+    extern NAME NAME##_new(pak_size sz);                                          \
+    extern NAME NAME##_new_alloc(pak_size sz, const pak_allocator *alloc);        \
     extern void NAME##_free(NAME *pp);                                            \
     extern int NAME##_insert(NAME dict, KEY_PARAM_TYPE key, VAL_PARAM_TYPE val);  \
     extern void NAME##_remove(NAME dict, KEY_PARAM_TYPE key);                     \
@@ -1518,6 +5640,23 @@ pak_ui32 pak_dict_murmur3(const pak_ui8 *data, unsigned int len, pak_ui32 seed)
    This library contains various utility functions for managing file input and
    output. You can do things such as opening text files as strings with a single
    function call.
+
+   Arrays can also be saved and loaded in a compact binary format, a small header
+   (format version, element size, count and an endianness tag) followed by the
+   raw elements, so a snapshot costs a single large write:
+
+        pak_arr_write(f, arr);
+        pak_farr arr = pak_arr_read(float, f);
+
+   Files written on a machine of the other endianness are byte swapped on load,
+   as long as the elements are 1, 2, 4 or 8 byte scalars. Arrays of strings have
+   their own encoding, every string's length followed by all of their bytes:
+
+        pak_sarr_write(f, names);
+        pak_sarr names = pak_sarr_read(f);
+
+   The strings read back are allocated with pak_malloc, one per string, and
+   belong to the caller. NULL strings are kept as NULL.
 */
 
 #ifndef PAK_NO_IO
@@ -1526,9 +5665,21 @@ pak_ui32 pak_dict_murmur3(const pak_ui8 *data, unsigned int len, pak_ui32 seed)
 #   error "PAK I/O depends on PAK arrays"
 #endif
 
+#ifndef PAK_IMPLEMENTATION
+#   include <stdio.h> /* FILE */
+#endif
+
 PAK_PREFIX char *pak_io_read_file(const char *path);
 PAK_PREFIX int pak_io_append_file(const char *path, const char *s, ...);
 
+/* Binary array snapshots, every call reads or writes one array at the position of "f" */
+PAK_PREFIX int pak_arr_write(FILE *f, const void *arr);
+PAK_PREFIX void *pak__arr_read(FILE *f, size_t sz);
+#define pak_arr_read(T, F) (T *) pak__arr_read((F), sizeof(T))
+
+PAK_PREFIX int pak_sarr_write(FILE *f, pak_sarr arr);
+PAK_PREFIX pak_sarr pak_sarr_read(FILE *f);
+
 #ifdef PAK_IMPLEMENTATION
 
 PAK_PREFIX pak_carr pak_io_read_file(const char *path)
@@ -1590,6 +5741,298 @@ fail:
     return -1;
 }
 
+#define PAK_IO_VERSION 1
+#define PAK_IO_ENDIAN  0x01020304 /* Reads back swapped on the other endianness */
+#define PAK_IO_NULL    0xFFFFFFFF /* Length of a NULL string */
+#define PAK_IO_CHUNK   (1 << 20)  /* Bytes read before trusting a stream for more */
+
+/* Header in front of every array written by pak_arr_write and pak_sarr_write */
+typedef struct {
+    char magic[4]; /* "PAKA" for arrays, "PAKS" for string arrays */
+    uint32_t version;
+    uint32_t endian;
+    uint32_t elem_sz;
+    uint64_t count;
+} pak__io_arr;
+
+static void pak__io_swap(void *p, size_t sz, size_t n)
+{
+    unsigned char *b = (unsigned char *)p;
+    size_t i, j;
+
+    for (i = 0; i < n; i++, b += sz) {
+        for (j = 0; j < sz / 2; j++) {
+            unsigned char t = b[j];
+            b[j] = b[sz - 1 - j];
+            b[sz - 1 - j] = t;
+        }
+    }
+}
+
+/* Reads "n" bytes into a new buffer which only grows as they arrive, so a corrupted
+   header can not make a short stream allocate more than it holds */
+static void *pak__io_read_bytes(FILE *f, size_t n)
+{
+    char *buf = NULL, *grown;
+    size_t done = 0, step = PAK_IO_CHUNK;
+
+    while (done < n) {
+        if (step > n - done)
+            step = n - done;
+
+        grown = (char *)pak_realloc(buf, done + step);
+        pak_assert(grown);
+        buf = grown;
+
+        pak_assert(fread(buf + done, 1, step, f) == step);
+        done += step;
+        step = done;
+    }
+
+    return buf;
+
+fail:
+    if (buf)
+        pak_free(buf);
+
+    return NULL;
+}
+
+static int pak__io_write_header(FILE *f, const char *magic, size_t sz, pak_size count)
+{
+    pak__io_arr h;
+
+    memcpy(h.magic, magic, sizeof(h.magic));
+    h.version = PAK_IO_VERSION;
+    h.endian = PAK_IO_ENDIAN;
+    h.elem_sz = (uint32_t)sz;
+    h.count = (uint64_t)count;
+
+    pak_assert(fwrite(&h, sizeof(h), 1, f) == 1);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+static int pak__io_read_header(FILE *f, const char *magic, pak__io_arr *h, pak_bool *swap)
+{
+    pak_assert(fread(h, sizeof(*h), 1, f) == 1);
+    pak_assert(memcmp(h->magic, magic, sizeof(h->magic)) == 0);
+
+    *swap = (h->endian != PAK_IO_ENDIAN) ? PAK_TRUE : PAK_FALSE;
+    if (*swap) {
+        pak__io_swap(&h->version, sizeof(uint32_t), 3);
+        pak__io_swap(&h->count, sizeof(uint64_t), 1);
+    }
+
+    pak_assert(h->endian == PAK_IO_ENDIAN);
+    pak_assert(h->version == PAK_IO_VERSION);
+    pak_assert(h->count <= (uint64_t)PAK_SIZE_MAX);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+PAK_PREFIX int pak_arr_write(FILE *f, const void *arr)
+{
+    const pak__arr *head = pak_arr_header(arr);
+
+    pak_assert(f);
+    pak_arr_check(head->sig == PAK_ARR_SIGNATURE);
+
+    pak_assert(pak__io_write_header(f, "PAKA", head->elem_sz, head->count) == 0);
+
+    if (head->count > 0)
+        pak_assert(fwrite(arr, head->elem_sz, head->count, f) == (size_t)head->count);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+PAK_PREFIX void *pak__arr_read(FILE *f, size_t sz)
+{
+    void *arr = NULL;
+    pak__io_arr h;
+    pak_bool swap;
+    pak_size count, done, step;
+
+    pak_assert(f);
+    pak_assert(pak__io_read_header(f, "PAKA", &h, &swap) == 0);
+    pak_assert(h.elem_sz == sz);
+
+    /* Only scalars can be byte swapped */
+    pak_assert(!swap || sz == 1 || sz == 2 || sz == 4 || sz == 8);
+
+    count = (pak_size)h.count;
+
+    /* The count is not trusted, the array starts small and doubles as elements arrive */
+    step = (pak_size)(PAK_IO_CHUNK / sz);
+    if (step > count)
+        step = count;
+
+    arr = pak__arr_new(sz, step > 0 ? step : 1);
+    pak_assert(arr);
+
+    for (done = 0; done < count; done += step) {
+        if (done == pak_arr_max(arr)) {
+            step = (count - done < done) ? count - done : done;
+            pak_assert(pak__arr_resize(&arr, done + step) == 0);
+        }
+
+        step = pak_arr_max(arr) - done;
+        pak_assert(fread((char *)arr + (size_t)done * sz, sz, (size_t)step, f) == (size_t)step);
+    }
+
+    pak_arr_header(arr)->count = count;
+
+    if (swap)
+        pak__io_swap(arr, sz, count);
+
+    return arr;
+
+fail:
+    if (arr)
+        pak__arr_free(&arr);
+
+    return NULL;
+}
+
+PAK_PREFIX int pak_sarr_write(FILE *f, pak_sarr arr)
+{
+    char *blob = NULL;
+    size_t blob_sz, off;
+    pak_size count, i;
+
+    pak_assert(f);
+    pak_arr_check(pak_arr_isvalid(arr));
+
+    count = pak_arr_count(arr);
+
+    /* Lengths first, then every string without its NULL byte */
+    blob_sz = count * sizeof(uint32_t);
+    for (i = 0; i < count; i++)
+        blob_sz += arr[i] ? strlen(arr[i]) : 0;
+
+    pak_assert(pak__io_write_header(f, "PAKS", 1, count) == 0);
+
+    if (blob_sz == 0)
+        return 0;
+
+    blob = (char *)pak_malloc(blob_sz);
+    pak_assert(blob);
+
+    off = count * sizeof(uint32_t);
+    for (i = 0; i < count; i++) {
+        uint32_t len = arr[i] ? (uint32_t)strlen(arr[i]) : PAK_IO_NULL;
+
+        memcpy(blob + i * sizeof(len), &len, sizeof(len));
+        if (arr[i]) {
+            memcpy(blob + off, arr[i], len);
+            off += len;
+        }
+    }
+
+    pak_assert(fwrite(blob, 1, blob_sz, f) == blob_sz);
+    pak_free(blob);
+
+    return 0;
+
+fail:
+    if (blob)
+        pak_free(blob);
+
+    return -1;
+}
+
+PAK_PREFIX pak_sarr pak_sarr_read(FILE *f)
+{
+    pak_sarr arr = NULL;
+    uint32_t *lens = NULL;
+    char *chars = NULL;
+    size_t chars_sz = 0, off = 0;
+    pak__io_arr h;
+    pak_bool swap;
+    pak_size count, i;
+
+    pak_assert(f);
+    pak_assert(pak__io_read_header(f, "PAKS", &h, &swap) == 0);
+    pak_assert(h.elem_sz == 1);
+
+    count = (pak_size)h.count;
+
+    /* Neither the count nor the lengths are trusted, nothing is allocated for them
+       until the stream has shown it holds what they promise */
+    if (count > 0) {
+        pak_assert((uint64_t)count <= (size_t)-1 / sizeof(*lens));
+        lens = (uint32_t *)pak__io_read_bytes(f, count * sizeof(*lens));
+        pak_assert(lens);
+    }
+
+    arr = pak_sarr_new(count > 0 ? count : 1);
+    pak_assert(arr);
+
+    if (count == 0)
+        return arr;
+
+    if (swap)
+        pak__io_swap(lens, sizeof(*lens), count);
+
+    for (i = 0; i < count; i++) {
+        if (lens[i] != PAK_IO_NULL) {
+            pak_assert(lens[i] <= (size_t)-1 - chars_sz);
+            chars_sz += lens[i];
+        }
+    }
+
+    if (chars_sz > 0) {
+        chars = (char *)pak__io_read_bytes(f, chars_sz);
+        pak_assert(chars);
+    }
+
+    for (i = 0; i < count; i++) {
+        char *s = NULL;
+
+        if (lens[i] != PAK_IO_NULL) {
+            s = (char *)pak_malloc(lens[i] + 1);
+            pak_assert(s);
+
+            if (lens[i] > 0)
+                memcpy(s, chars + off, lens[i]);
+            s[lens[i]] = '\0';
+            off += lens[i];
+        }
+
+        arr[i] = s;
+        pak_arr_header(arr)->count++;
+    }
+
+    pak_free(lens);
+    if (chars)
+        pak_free(chars);
+
+    return arr;
+
+fail:
+    if (arr) {
+        for (i = 0; i < pak_arr_count(arr); i++)
+            if (arr[i])
+                pak_free(arr[i]);
+        pak_sarr_free(&arr);
+    }
+    if (lens)
+        pak_free(lens);
+    if (chars)
+        pak_free(chars);
+
+    return NULL;
+}
+
 #endif /* PAK_IMPLEMENTATION */
 #endif /* PAK_NO_IO */
 
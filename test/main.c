@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime, mmap */
+
 #include "pak_test.h"
 
 #define PAK_IMPLEMENTATION
@@ -5,12 +7,18 @@
 
 #include "pak_list_test.h"
 #include "pak_arr_test.h"
+#include "pak_deque_test.h"
+#include "pak_segarr_test.h"
+#include "pak_bitset_test.h"
 
 int main()
 {
     pak_test_init();
 
     pak_test_begin(pak_arr_test);
+    pak_test_begin(pak_deque_test);
+    pak_test_begin(pak_segarr_test);
+    pak_test_begin(pak_bitset_test);
     pak_test_begin(pak_list_test);
 
     pak_test_exit();
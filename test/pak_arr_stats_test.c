@@ -0,0 +1,119 @@
+/*
+    PAK_ARR_STATS changes the array header, so every file of a program has to
+    agree on it. This test is its own program, built by the "stats" target,
+    and keeps the main suite on the default header layout.
+*/
+
+#define _POSIX_C_SOURCE 200809L /* clock_gettime, mmap */
+
+#include "pak_test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define PAK_ARR_STATS
+#define PAK_IMPLEMENTATION
+#include <pak.h>
+
+PAK_INIT_ARR(IntArray, int, NULL);
+PAK_INIT_ARR(UntaggedArray, int, NULL);
+#define IntArray_new(M) ((IntArray) pak_arr_stats_site(IntArray_new(M)))
+
+// Test the instrumentation counters, per array, per site and in total
+char *pak_arr_stats_counters_test()
+{
+    int i, *raw;
+    pak_arr_stats s;
+    char line[512];
+    int found = 0;
+
+    pak_arr_stats_reset();
+
+    IntArray arr = IntArray_new(4);
+    pak_test_assert(arr, "Failed to create array.");
+    for (i = 0; i < 10; i++)
+        IntArray_push(&arr, i);
+    for (i = 0; i < 3; i++)
+        IntArray_pop(&arr);
+
+    s = pak_arr_stats_of(arr);
+    pak_test_assert(s.pushes == 10 && s.pops == 3, "Counted %lu pushes and %lu pops.",
+            s.pushes, s.pops);
+    pak_test_assert(s.resizes == 2, "Counted %lu resizes.", s.resizes);
+    // Resizes copy the header as well, and only when realloc moved the block
+    pak_test_assert(s.copied <= 2 * sizeof(pak__arr) + (4 + 8) * sizeof(int),
+            "Counted %lu bytes copied.",
+            (unsigned long)s.copied);
+    pak_test_assert(s.peak_count == 10 && s.peak_max == 12, "Peaked at %d of %d.",
+            (int)s.peak_count, (int)s.peak_max);
+
+    raw = pak_arr_new(int, 2);
+    pak_test_assert(raw, "Failed to create raw array.");
+    pak_arr_push(&raw, i);
+
+    s = pak_arr_stats_get();
+    pak_test_assert(s.arrays == 2 && s.pushes == 11, "Counted %lu arrays and %lu pushes in total.",
+            s.arrays, s.pushes);
+
+    // Both creating lines show up in the dump, the raw one under this file
+    FILE *f = tmpfile();
+    pak_test_assert(f, "Failed to open a temporary file.");
+    pak_arr_stats_dump(f);
+    rewind(f);
+    while (fgets(line, sizeof(line), f))
+        if (strstr(line, "pak_arr_stats_test.c:"))
+            found++;
+    fclose(f);
+    pak_test_assert(found == 2, "Found %d call sites in the dump.", found);
+
+    IntArray_free(&arr);
+    pak_arr_free(&raw);
+
+    return NULL;
+}
+
+// Test that typed arrays are listed under the line which created them
+char *pak_arr_stats_sites_test()
+{
+    pak_arr_stats s;
+    int line;
+
+    pak_arr_stats_reset();
+
+    line = __LINE__; pak_iarr ints = pak_iarr_new(4);
+    pak_test_assert(ints && pak_arr_header(ints)->site, "Common type was not tagged.");
+    pak_test_assert(pak_arr_header(ints)->site->line == line &&
+            strstr(pak_arr_header(ints)->site->file, "pak_arr_stats_test.c"),
+            "Common type was listed under %s:%d.", pak_arr_header(ints)->site->file,
+            pak_arr_header(ints)->site->line);
+
+    line = __LINE__; IntArray wrapped = IntArray_new(4);
+    pak_test_assert(wrapped && pak_arr_header(wrapped)->site->line == line,
+            "Wrapped constructor was listed under line %d.", pak_arr_header(wrapped)->site->line);
+    s = pak_arr_header(wrapped)->site->stats;
+    pak_test_assert(s.arrays == 1, "Wrapped array was counted %lu times.", s.arrays);
+
+    // Without a wrapper the PAK_INIT_ARR line is the best a function knows
+    UntaggedArray plain = UntaggedArray_new(4);
+    pak_test_assert(plain && pak_arr_header(plain)->site->line < line,
+            "Unwrapped constructor was listed under line %d.", pak_arr_header(plain)->site->line);
+
+    s = pak_arr_stats_get();
+    pak_test_assert(s.arrays == 3, "Counted %lu arrays in total.", s.arrays);
+
+    pak_iarr_free(&ints);
+    IntArray_free(&wrapped);
+    UntaggedArray_free(&plain);
+
+    return NULL;
+}
+
+int main()
+{
+    pak_test_init();
+
+    pak_test_begin(pak_arr_stats_counters_test);
+    pak_test_begin(pak_arr_stats_sites_test);
+
+    pak_test_exit();
+}
@@ -1,7 +1,11 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
 #include "pak_test.h"
 #include "pak_arr_test.h"
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <pak.h>
 
 PAK_INIT_ARR(IntArray, int, NULL);
@@ -13,6 +17,62 @@ void arr_gc(void *e)
 }
 PAK_INIT_ARR(GCArray, int*, arr_gc);
 
+static int arr_gc_calls, arr_gc_elems;
+
+void arr_count_gc(void *e)
+{
+    arr_gc_calls++;
+    arr_gc_elems += *(int *)e;
+}
+
+void arr_count_gc_range(void *first, size_t n)
+{
+    int *e = (int *) first;
+
+    arr_gc_calls++;
+    while (n--)
+        arr_gc_elems += *e++;
+}
+PAK_INIT_ARR(CountArray, int, arr_count_gc);
+
+void arr_gc_range(void *first, size_t n)
+{
+    int **p = (int **) first;
+
+    while (n--)
+        free(*p++);
+}
+
+PAK_INIT_ARR_EX(GeoArray, int, NULL, pak_arr_growth_mul(2.0f));
+PAK_INIT_ARR_EX_ALIGNED(AlignedArray, float, NULL, pak_arr_growth_mul(2.0f), 64);
+
+typedef struct {
+    int key;
+    int order;
+} arr_pair;
+
+#define arr_pair_less(A, B) ((A).key < (B).key)
+PAK_INIT_ARR(PairArray, arr_pair, NULL);
+PAK_INIT_ARR_SORT(PairArray, arr_pair, arr_pair_less);
+PAK_INIT_ARR_SEARCH(PairArray, arr_pair, arr_pair_less);
+
+PAK_INIT_SOA(Particles, (float, x), (float, y), (float, vx), (float, vy), (int, id));
+PAK_INIT_SOA(Ids, (long, id));
+
+typedef struct {
+    float x, y, vx, vy;
+    int id;
+} arr_particle;
+PAK_INIT_ARR(ParticleArray, arr_particle, NULL);
+
+pak_size arr_grow_pow2(pak_size max, pak_size need)
+{
+    while (max < need)
+        max <<= 1;
+
+    return max;
+}
+
 // Test out raw PAK vectors (the non-typesafe void* ones)
 char *pak_arr_raw_test()
 {
@@ -98,11 +158,1100 @@ char *pak_arr_gc_test()
     return NULL;
 }
 
+// Test range destructors get every removed element, in as few calls as possible
+char *pak_arr_gc_range_test()
+{
+    static const int NUM_VALS = 1000000;
+    clock_t begin;
+    int i, range;
+
+    // Every element is counted once, including the first one
+    for (range = 0; range < 2; range++) {
+        CountArray arr = CountArray_new(16);
+        pak_test_assert(arr, "Failed to create array.");
+
+        if (range)
+            CountArray_set_gc_range(arr, arr_count_gc_range);
+
+        for (i = 0; i < 100; i++)
+            CountArray_push(&arr, 1);
+
+        arr_gc_calls = arr_gc_elems = 0;
+        CountArray_erase_range(&arr, 10, 20);
+        pak_test_assert(arr_gc_elems == 20 && arr_gc_calls == (range ? 1 : 20), "Erase missed elements.");
+
+        arr_gc_calls = arr_gc_elems = 0;
+        CountArray_pop(&arr);
+        CountArray_swap_remove(&arr, 0);
+        CountArray_erase_at(&arr, 0);
+        pak_test_assert(arr_gc_elems == 3 && arr_gc_calls == 3, "Single removals missed elements.");
+
+        arr_gc_calls = arr_gc_elems = 0;
+        CountArray_resize(&arr, 50);
+        pak_test_assert(arr_gc_elems == 27 && arr_gc_calls == (range ? 1 : 27), "Resize missed elements.");
+
+        arr_gc_calls = arr_gc_elems = 0;
+        CountArray_free(&arr);
+        pak_test_assert(arr_gc_elems == 50 && arr_gc_calls == (range ? 1 : 50), "Free missed elements.");
+    }
+
+    // Compare freeing with and without a range destructor
+    for (range = 0; range < 2; range++) {
+        GCArray arr = GCArray_new(NUM_VALS);
+        pak_test_assert(arr, "Failed to create GC array.");
+
+        if (range)
+            GCArray_set_gc_range(arr, arr_gc_range);
+
+        for (i = 0; i < NUM_VALS; i++)
+            GCArray_push(&arr, malloc(sizeof(int)));
+
+        begin = clock();
+        GCArray_free(&arr);
+        pak_test_debug("Freeing %d pointers %s: %lf sec", NUM_VALS, range ? "by range" : "one by one",
+                (double)(clock() - begin)/CLOCKS_PER_SEC);
+    }
+
+    return NULL;
+}
+
+// Allocator which counts its live allocations
+typedef struct {
+    int live;
+    int total;
+    size_t bytes;
+} arr_counter;
+
+void *arr_counter_alloc(void *ctx, size_t sz)
+{
+    arr_counter *c = ctx;
+    c->live++;
+    c->total++;
+    return malloc(sz);
+}
+
+void *arr_counter_realloc(void *ctx, void *p, size_t sz)
+{
+    arr_counter *c = ctx;
+    c->total++;
+    c->bytes += sz;
+    return realloc(p, sz);
+}
+
+void arr_counter_free(void *ctx, void *p)
+{
+    arr_counter *c = ctx;
+    c->live--;
+    free(p);
+}
+
+// Test growth policies, and count the resizes each one does
+char *pak_arr_growth_test()
+{
+    static const int NUM_PUSHES = 200000;
+    arr_counter geo_count = { 0, 0, 0 }, add_count = { 0, 0, 0 };
+    pak_allocator geo_alloc = { arr_counter_alloc, arr_counter_realloc, arr_counter_free, &geo_count };
+    pak_allocator add_alloc = { arr_counter_alloc, arr_counter_realloc, arr_counter_free, &add_count };
+    int i;
+
+    GeoArray geo = GeoArray_new_alloc(16, &geo_alloc);
+    pak_test_assert(geo, "Failed to create geometric array.");
+
+    for (i = 0; i < NUM_PUSHES; i++) {
+        int rc = GeoArray_push(&geo, i);
+        pak_test_assert(rc == 0, "Failed to push value onto geometric array.");
+    }
+
+    pak_test_assert(GeoArray_max(geo) == 262144, "Geometric array grew to %d.", (int)GeoArray_max(geo));
+    for (i = 0; i < NUM_PUSHES; i++)
+        pak_test_assert(geo[i] == i, "Geometric array lost value at %d.", i);
+
+    GeoArray_free(&geo);
+
+    IntArray add = IntArray_new_alloc(16, &add_alloc);
+    pak_test_assert(add, "Failed to create additive array.");
+
+    for (i = 0; i < NUM_PUSHES; i++) {
+        int rc = IntArray_push(&add, i);
+        pak_test_assert(rc == 0, "Failed to push value onto additive array.");
+    }
+
+    pak_test_assert(IntArray_max(add) == NUM_PUSHES, "Additive array grew to %d.", (int)IntArray_max(add));
+    IntArray_free(&add);
+
+    pak_test_debug("Geometric growth: %d resizes, %lu bytes reallocated", geo_count.total - 1,
+            (unsigned long)geo_count.bytes);
+    pak_test_debug("Additive growth: %d resizes, %lu bytes reallocated", add_count.total - 1,
+            (unsigned long)add_count.bytes);
+
+    // Doubling from 16 to 262144 takes 14 steps, which together reallocate
+    // about twice the final size. Steps of 16 take one per 16 pushes, and
+    // the bytes they reallocate grow with the square of the count.
+    pak_test_assert(geo_count.total - 1 == 14, "Geometric array resized %d times.", geo_count.total - 1);
+    pak_test_assert(geo_count.bytes < 4 * 262144 * sizeof(int), "Geometric array reallocated too much.");
+    pak_test_assert(add_count.total - 1 == (NUM_PUSHES - 16) / 16,
+            "Additive array resized %d times.", add_count.total - 1);
+    pak_test_assert(add_count.bytes > 1000 * geo_count.bytes,
+            "Additive growth did not reallocate quadratically.");
+
+    int *arr = pak_arr_new_growth(int, 3, NULL, pak_arr_growth_func(arr_grow_pow2));
+    pak_test_assert(arr, "Failed to create callback growth array.");
+
+    for (i = 0; i < 100; i++)
+        pak_arr_push(&arr, i);
+
+    pak_test_assert(pak_arr_max(arr) == 192, "Callback array grew to %d.", (int)pak_arr_max(arr));
+    pak_arr_free(&arr);
+
+    return NULL;
+}
+
+// Allocator which hands out a small block whatever it is asked for, so arrays can claim
+// a max near PAK_SIZE_MAX, and fails every realloc after noting the size asked for
+static size_t arr_liar_asked;
+
+void *arr_liar_alloc(void *ctx, size_t sz)
+{
+    (void)ctx;
+    (void)sz;
+    return malloc(sizeof(pak__arr) + 64);
+}
+
+void *arr_liar_realloc(void *ctx, void *p, size_t sz)
+{
+    (void)ctx;
+    (void)p;
+    arr_liar_asked = sz;
+    return NULL;
+}
+
+void arr_liar_free(void *ctx, void *p)
+{
+    (void)ctx;
+    free(p);
+}
+
+// Test that sizes near PAK_SIZE_MAX fail instead of overflowing
+char *pak_arr_size_test()
+{
+    pak_allocator liar = { arr_liar_alloc, arr_liar_realloc, arr_liar_free, NULL };
+    char *big;
+
+    pak_test_assert(pak__arr_alloc_sz(sizeof(int), 16, 0) == sizeof(pak__arr) + 16 * sizeof(int),
+            "Wrong allocation size.");
+    pak_test_assert(pak__arr_alloc_sz((size_t)-1 / 2, 3, 0) == 0, "Allocation size overflowed.");
+    pak_test_assert(pak__arr_alloc_sz(sizeof(int), -1, 0) == 0, "Allocated a negative size.");
+
+    // Growth steps that would pass PAK_SIZE_MAX settle for what is needed
+    big = pak_arr_new_ex(char, PAK_SIZE_MAX - 10, NULL, pak_arr_growth_add(), 0, &liar);
+    pak_test_assert(big, "Failed to create array.");
+    pak_test_assert(pak_arr_reserve(&big, PAK_SIZE_MAX - 5) == -1, "Lying allocator did not fail.");
+    pak_test_assert(arr_liar_asked == pak__arr_alloc_sz(1, PAK_SIZE_MAX - 5, 0),
+            "Additive growth overflowed.");
+    pak_arr_free(&big);
+
+    big = pak_arr_new_ex(char, PAK_SIZE_MAX / 2 + 1, NULL, pak_arr_growth_mul(2.0f), 0, &liar);
+    pak_test_assert(big, "Failed to create array.");
+    pak_test_assert(pak_arr_reserve(&big, PAK_SIZE_MAX - 5) == -1, "Lying allocator did not fail.");
+    pak_test_assert(arr_liar_asked == pak__arr_alloc_sz(1, PAK_SIZE_MAX - 5, 0),
+            "Multiplicative growth overflowed.");
+    pak_arr_free(&big);
+
+    IntArray arr = IntArray_new(4);
+    pak_test_assert(arr, "Failed to create array.");
+    IntArray_push(&arr, 1);
+
+    pak_test_assert(IntArray_push_n(&arr, arr, PAK_SIZE_MAX) == -1, "Pushed past PAK_SIZE_MAX.");
+    pak_test_assert(IntArray_push_n(&arr, arr, -1) == -1, "Pushed a negative count.");
+    pak_test_assert(IntArray_count(arr) == 1 && arr[0] == 1, "Failed push changed the array.");
+
+    IntArray_free(&arr);
+
+    return NULL;
+}
+
+// Test shrink hysteresis, reserving and shrinking to fit
+char *pak_arr_reserve_test()
+{
+    int i, j;
+
+    IntArray arr = IntArray_new(16);
+    pak_test_assert(arr, "Failed to create array.");
+
+    for (i = 0; i < 64; i++)
+        IntArray_push(&arr, i);
+
+    pak_test_assert(IntArray_max(arr) == 64, "Array should have grown to 64.");
+
+    // Hover around a capacity boundary, nothing should be resized
+    for (j = 0; j < 100; j++) {
+        for (i = 0; i < 16; i++)
+            IntArray_pop(&arr);
+
+        pak_test_assert(IntArray_max(arr) == 64, "Array shrank while above the hysteresis band.");
+
+        for (i = 0; i < 16; i++)
+            IntArray_push(&arr, i);
+    }
+
+    // Dropping below a quarter shrinks down to about half full
+    while (IntArray_count(arr) > 15)
+        IntArray_pop(&arr);
+
+    pak_test_assert(IntArray_max(arr) == 32, "Array shrank to %d instead of 32.", (int)IntArray_max(arr));
+
+    // Reserved space is never given back by pops
+    pak_test_assert(IntArray_reserve(&arr, 1000) == 0, "Failed to reserve array.");
+    pak_test_assert(IntArray_max(arr) == 1000, "Reserve did not resize the array.");
+
+    for (i = 0; i < 1000; i++)
+        IntArray_push(&arr, i);
+
+    while (IntArray_count(arr) > 0)
+        IntArray_pop(&arr);
+
+    pak_test_assert(IntArray_max(arr) == 1000, "Array shrank below its reserved size.");
+
+    for (i = 0; i < 10; i++)
+        IntArray_push(&arr, i);
+
+    pak_test_assert(IntArray_shrink_to_fit(&arr) == 0, "Failed to shrink array to fit.");
+    pak_test_assert(IntArray_max(arr) == 10, "Array did not shrink to fit.");
+
+    for (i = 0; i < 10; i++)
+        pak_test_assert(arr[i] == i, "Array lost value at %d.", i);
+
+    IntArray_free(&arr);
+
+    return NULL;
+}
+
+// Test bulk appends, inserts and erases
+char *pak_arr_bulk_test()
+{
+    static const int NUM_VALS = 1000000;
+    int i;
+
+    int *vals = malloc(sizeof(*vals) * NUM_VALS);
+    pak_test_assert(vals, "Failed to allocate values.");
+
+    for (i = 0; i < NUM_VALS; i++)
+        vals[i] = i;
+
+    IntArray arr = IntArray_new(16);
+    pak_test_assert(arr, "Failed to create array.");
+
+    pak_test_assert(IntArray_push_n(&arr, vals, NUM_VALS) == 0, "Failed to push values.");
+    pak_test_assert(IntArray_count(arr) == NUM_VALS, "Array has the wrong count after push_n.");
+
+    for (i = 0; i < NUM_VALS; i++)
+        pak_test_assert(arr[i] == i, "Array lost value at %d.", i);
+
+    free(vals);
+
+    // Extending an array with itself doubles it
+    pak_test_assert(IntArray_extend(&arr, arr) == 0, "Failed to extend array.");
+    pak_test_assert(IntArray_count(arr) == NUM_VALS * 2, "Array has the wrong count after extend.");
+    pak_test_assert(arr[NUM_VALS + 123] == 123, "Extend copied the wrong values.");
+
+    pak_test_assert(IntArray_erase_range(&arr, 10, NUM_VALS * 2 - 20) == 0, "Failed to erase range.");
+    pak_test_assert(IntArray_count(arr) == 20, "Array has the wrong count after erase.");
+    pak_test_assert(arr[9] == 9 && arr[10] == NUM_VALS - 10, "Erase moved the wrong values.");
+
+    int mid[] = { -1, -2, -3 };
+    pak_test_assert(IntArray_insert_range(&arr, 10, mid, 3) == 0, "Failed to insert range.");
+    pak_test_assert(IntArray_count(arr) == 23, "Array has the wrong count after insert.");
+    pak_test_assert(arr[9] == 9 && arr[10] == -1 && arr[12] == -3 && arr[13] == NUM_VALS - 10,
+            "Insert moved the wrong values.");
+
+    pak_test_assert(IntArray_insert_range(&arr, 24, mid, 3) != 0, "Inserted out of bounds.");
+    pak_test_assert(IntArray_erase_range(&arr, 20, 4) != 0, "Erased out of bounds.");
+
+    IntArray_free(&arr);
+
+    // Erased elements are garbage collected
+    GCArray gc = GCArray_new(16);
+    pak_test_assert(gc, "Failed to create GC array.");
+
+    for (i = 0; i < 100; i++) {
+        int *p = malloc(sizeof(int));
+        *p = i;
+        GCArray_push(&gc, p);
+    }
+
+    pak_test_assert(GCArray_erase_range(&gc, 0, 50) == 0, "Failed to erase GC range.");
+    pak_test_assert(*gc[0] == 50, "GC erase moved the wrong values.");
+
+    GCArray_free(&gc);
+
+    return NULL;
+}
+
+// Test single element inserts and erases, and swap removes
+char *pak_arr_erase_test()
+{
+    int i;
+
+    IntArray arr = IntArray_new(4);
+    pak_test_assert(arr, "Failed to create array.");
+
+    for (i = 0; i < 10; i++)
+        pak_test_assert(IntArray_insert_at(&arr, 0, i) == 0, "Failed to insert at the front.");
+    pak_test_assert(arr[0] == 9 && arr[9] == 0, "Insert at the front is out of order.");
+
+    pak_test_assert(IntArray_insert_at(&arr, 10, i) == 0, "Failed to insert at the end.");
+    pak_test_assert(IntArray_insert_at(&arr, 12, i) != 0, "Inserted out of bounds.");
+
+    pak_test_assert(IntArray_erase_at(&arr, 3) == 0, "Failed to erase at index.");
+    pak_test_assert(IntArray_count(arr) == 10 && arr[2] == 7 && arr[3] == 5,
+            "Erase at index moved the wrong values.");
+
+    // The last element fills the hole
+    pak_test_assert(IntArray_swap_remove(&arr, 1) == 0, "Failed to swap remove.");
+    pak_test_assert(IntArray_count(arr) == 9 && arr[1] == 10, "Swap remove moved the wrong value.");
+
+    pak_test_assert(IntArray_swap_remove(&arr, 8) == 0, "Failed to swap remove the last element.");
+    pak_test_assert(IntArray_count(arr) == 8 && arr[7] == 1, "Swap remove of the last element failed.");
+    pak_test_assert(IntArray_swap_remove(&arr, 8) != 0, "Swap removed out of bounds.");
+
+    while (IntArray_count(arr) > 0)
+        pak_test_assert(IntArray_swap_remove(&arr, 0) == 0, "Failed to empty the array.");
+    pak_test_assert(IntArray_erase_at(&arr, 0) != 0, "Erased from an empty array.");
+
+    IntArray_free(&arr);
+
+    // Removed elements are garbage collected
+    GCArray gc = GCArray_new(16);
+    pak_test_assert(gc, "Failed to create GC array.");
+
+    for (i = 0; i < 100; i++) {
+        int *p = malloc(sizeof(int));
+        *p = i;
+        GCArray_push(&gc, p);
+    }
+
+    for (i = 0; i < 50; i++)
+        pak_test_assert(GCArray_swap_remove(&gc, 0) == 0, "Failed to swap remove GC element.");
+    for (i = 0; i < 25; i++)
+        pak_test_assert(GCArray_erase_at(&gc, 10) == 0, "Failed to erase GC element.");
+    pak_test_assert(GCArray_count(gc) == 25, "GC array has the wrong count.");
+
+    GCArray_free(&gc);
+
+    return NULL;
+}
+
+// Test that aligned arrays stay aligned through resizes
+char *pak_arr_aligned_test()
+{
+    static const int NUM_PUSHES = 100000;
+    int i;
+
+    AlignedArray arr = AlignedArray_new(3);
+    pak_test_assert(arr, "Failed to create aligned array.");
+
+    for (i = 0; i < NUM_PUSHES; i++) {
+        int rc = AlignedArray_push(&arr, (float)i);
+        pak_test_assert(rc == 0, "Failed to push value onto aligned array.");
+        pak_test_assert((uintptr_t)arr % 64 == 0, "Array lost its alignment after %d pushes.", i);
+    }
+
+    for (i = 0; i < NUM_PUSHES; i++)
+        pak_test_assert(arr[i] == (float)i, "Aligned array lost value at %d.", i);
+
+    while (AlignedArray_count(arr) > 1) {
+        AlignedArray_pop(&arr);
+        pak_test_assert((uintptr_t)arr % 64 == 0, "Array lost its alignment after a pop.");
+    }
+
+    AlignedArray_free(&arr);
+
+    double *raw = pak_arr_new_aligned(double, 5, 32);
+    pak_test_assert(raw, "Failed to create raw aligned array.");
+
+    for (i = 0; i < 1000; i++) {
+        double d = i;
+        pak_arr_push(&raw, d);
+        pak_test_assert((uintptr_t)raw % 32 == 0, "Raw array lost its alignment.");
+    }
+
+    pak_test_assert(raw[999] == 999.0, "Raw aligned array lost a value.");
+    pak_arr_free(&raw);
+
+    pak_test_assert(!pak_arr_new_aligned(int, 5, 24), "Created an array with a bad alignment.");
+
+    return NULL;
+}
+
+// Test arrays using their own allocator
+char *pak_arr_alloc_test()
+{
+    arr_counter counter = { 0, 0, 0 };
+    pak_allocator alloc = { arr_counter_alloc, arr_counter_realloc, arr_counter_free, &counter };
+    int i;
+
+    IntArray arr = IntArray_new_alloc(16, &alloc);
+    pak_test_assert(arr, "Failed to create array with an allocator.");
+    pak_test_assert(counter.live == 1, "Array was not allocated through its allocator.");
+
+    for (i = 0; i < 1000; i++)
+        IntArray_push(&arr, i);
+
+    pak_test_assert(counter.total > 1, "Array was not resized through its allocator.");
+
+    IntArray_free(&arr);
+    pak_test_assert(counter.live == 0, "Array was not free'd through its allocator.");
+
+    double *raw = pak_arr_new_alloc(double, 4, &alloc);
+    pak_test_assert(raw && counter.live == 1, "Failed to create raw array with an allocator.");
+    pak_arr_free(&raw);
+    pak_test_assert(counter.live == 0, "Raw array was not free'd through its allocator.");
+
+    return NULL;
+}
+
+// Test arrays living inside of stack buffers
+char *pak_arr_buf_test()
+{
+    int i;
+
+    PAK_ARR_BUF(buf, int, 32);
+    IntArray arr = IntArray_new_buf(&buf, sizeof(buf));
+    pak_test_assert(arr, "Failed to create array inside of a buffer.");
+    pak_test_assert(IntArray_max(arr) == 32, "Buffer array should hold 32 elements.");
+
+    for (i = 0; i < 32; i++)
+        IntArray_push(&arr, i);
+
+    pak_test_assert((char *)arr > (char *)&buf && (char *)arr < (char *)&buf + sizeof(buf),
+            "Array left its buffer before it was full.");
+
+    for (i = 32; i < 1000; i++)
+        IntArray_push(&arr, i);
+
+    pak_test_assert((char *)arr < (char *)&buf || (char *)arr >= (char *)&buf + sizeof(buf),
+            "Array did not spill over to the heap.");
+
+    for (i = 0; i < 1000; i++)
+        pak_test_assert(arr[i] == i, "Spilled array lost value at %d.", i);
+
+    IntArray_free(&arr);
+
+    // Arrays which never spill do not touch the heap at all
+    PAK_ARR_BUF(small, double, 8);
+    double *raw = pak_arr_new_buf(double, small);
+    pak_test_assert(raw, "Failed to create raw array inside of a buffer.");
+
+    for (i = 0; i < 8; i++) {
+        double d = i;
+        pak_arr_push(&raw, d);
+    }
+
+    for (i = 0; i < 8; i++)
+        pak_arr_pop(&raw);
+
+    pak_test_assert(pak_arr_max(raw) == 8, "Buffer array shrank.");
+    pak_arr_free(&raw);
+    pak_test_assert(!raw, "Array should be NULL after free.");
+
+    // Aligned arrays line up their first element inside the buffer, and on the heap
+    PAK_ARR_BUF(floats, float, 64);
+    AlignedArray aligned = AlignedArray_new_buf((char *)&floats + 4, sizeof(floats) - 4);
+    pak_test_assert(aligned, "Failed to create aligned array inside of a buffer.");
+    pak_test_assert((uintptr_t)aligned % 64 == 0, "Buffer array is not aligned.");
+    pak_test_assert((char *)(aligned + AlignedArray_max(aligned)) <= (char *)&floats + sizeof(floats),
+            "Aligned buffer array runs past its buffer.");
+
+    for (i = 0; i < 1000; i++)
+        AlignedArray_push(&aligned, (float)i);
+
+    pak_test_assert((uintptr_t)aligned % 64 == 0, "Spilled buffer array lost its alignment.");
+    pak_test_assert(aligned[999] == 999.0f, "Spilled aligned array lost a value.");
+    AlignedArray_free(&aligned);
+
+    return NULL;
+}
+
+// Test struct of arrays rows stay in sync, and compare a column loop against structs
+char *pak_arr_soa_test()
+{
+    static const int NUM_ROWS = 1000000;
+    static const int NUM_STEPS = 20;
+    clock_t begin;
+    int i, s;
+
+    Particles p = Particles_new(16);
+    ParticleArray aos = ParticleArray_new(NUM_ROWS);
+    pak_test_assert(p && aos, "Failed to create particles.");
+
+    for (i = 0; i < NUM_ROWS; i++) {
+        arr_particle q = { i, -i, 1.0f, 0.5f, i };
+        pak_test_assert(Particles_push(p, q.x, q.y, q.vx, q.vy, q.id) == 0, "Failed to push row.");
+        ParticleArray_push(&aos, q);
+    }
+
+    pak_test_assert(Particles_count(p) == NUM_ROWS, "Wrong row count.");
+    pak_test_assert(((uintptr_t)p->x & 63) == 0 && ((uintptr_t)Particles_col_id(p) & 63) == 0,
+            "Columns are not aligned.");
+
+    begin = clock();
+    for (s = 0; s < NUM_STEPS; s++) {
+        float *x = p->x, *y = p->y, *vx = p->vx, *vy = p->vy;
+        int n = Particles_count(p);
+
+        for (i = 0; i < n; i++) {
+            x[i] += vx[i];
+            y[i] += vy[i];
+        }
+    }
+    pak_test_debug("Struct of arrays: %d steps in %lf sec", NUM_STEPS,
+            (double)(clock() - begin)/CLOCKS_PER_SEC);
+
+    begin = clock();
+    for (s = 0; s < NUM_STEPS; s++) {
+        for (i = 0; i < ParticleArray_count(aos); i++) {
+            aos[i].x += aos[i].vx;
+            aos[i].y += aos[i].vy;
+        }
+    }
+    pak_test_debug("Array of structs: %d steps in %lf sec", NUM_STEPS,
+            (double)(clock() - begin)/CLOCKS_PER_SEC);
+
+    for (i = 0; i < NUM_ROWS; i += 1000)
+        pak_test_assert(p->x[i] == aos[i].x && p->y[i] == aos[i].y, "Layouts disagree at %d.", i);
+
+    // Removing rows keeps every column in sync
+    pak_test_assert(Particles_swap_remove(p, 0) == 0, "Failed to swap remove.");
+    pak_test_assert(p->id[0] == NUM_ROWS - 1 && p->x[0] == aos[NUM_ROWS - 1].x,
+            "Swap remove broke a row.");
+    pak_test_assert(Particles_pop(p) == 0 && Particles_count(p) == NUM_ROWS - 2, "Failed to pop.");
+    pak_test_assert(Particles_swap_remove(p, NUM_ROWS - 2) != 0, "Swap removed out of bounds.");
+
+    for (i = 0; i < Particles_count(p); i += 997)
+        pak_test_assert(p->y[i] == -(float)p->id[i] + NUM_STEPS * 0.5f, "Row %d is out of sync.", i);
+
+    Particles_free(&p);
+    ParticleArray_free(&aos);
+    pak_test_assert(!p, "Struct of arrays should be NULL after free.");
+
+    // Single columns work too
+    Ids ids = Ids_new(1);
+    pak_test_assert(ids, "Failed to create ids.");
+    for (i = 0; i < 100; i++)
+        Ids_push(ids, i);
+    pak_test_assert(Ids_max(ids) >= 100 && ids->id[99] == 99, "Single column lost values.");
+    pak_test_assert(Ids_reserve(ids, 1000) == 0 && Ids_max(ids) == 1000, "Failed to reserve.");
+    Ids_free(&ids);
+
+    return NULL;
+}
+
+// Test arrays mapped from a file, written by one map and read back by another
+char *pak_arr_map_test()
+{
+#ifdef PAK__ARR_MMAP
+    static const char *PATH = "/tmp/pak_arr_map_test.bin";
+    static const int NUM_PUSHES = 100000;
+    int i;
+
+    pak_larr arr = pak_larr_map_file(PATH, PAK_ARR_MAP_WRITE | PAK_ARR_MAP_CREATE);
+    pak_test_assert(arr, "Failed to create mapped array.");
+    pak_test_assert(pak_larr_count(arr) == 0, "New mapped array is not empty.");
+
+    for (i = 0; i < NUM_PUSHES; i++)
+        pak_test_assert(pak_larr_push(&arr, (long)i * 3) == 0, "Failed to grow mapped array.");
+
+    pak_larr_free(&arr);
+
+    // Read only maps see everything, and keep their changes to themselves
+    arr = pak_larr_map_file(PATH, PAK_ARR_MAP_READ);
+    pak_test_assert(arr, "Failed to map array for reading.");
+    pak_test_assert(pak_larr_count(arr) == NUM_PUSHES, "Mapped array lost its count.");
+
+    for (i = 0; i < NUM_PUSHES; i++)
+        pak_test_assert(arr[i] == (long)i * 3, "Mapped array lost value at %d.", i);
+
+    arr[0] = -1;
+    pak_test_assert(pak_larr_reserve(&arr, NUM_PUSHES * 4) != 0, "Read only map grew.");
+    pak_larr_free(&arr);
+
+    // Writable maps can shrink and grow the file again
+    arr = pak_larr_map_file(PATH, PAK_ARR_MAP_WRITE);
+    pak_test_assert(arr && arr[0] == 0, "Private changes reached the file.");
+
+    pak_test_assert(pak_larr_erase_range(&arr, 10, NUM_PUSHES - 20) == 0, "Failed to erase.");
+    pak_test_assert(pak_larr_shrink_to_fit(&arr) == 0, "Failed to shrink mapped array.");
+    pak_test_assert(pak_larr_max(arr) == 20, "Mapped array did not shrink.");
+    pak_test_assert(pak_larr_push(&arr, -5L) == 0, "Failed to push after shrinking.");
+    pak_larr_free(&arr);
+
+    arr = pak_larr_map_file(PATH, PAK_ARR_MAP_READ);
+    pak_test_assert(arr && pak_larr_count(arr) == 21, "Mapped array has the wrong count.");
+    pak_test_assert(arr[9] == 27 && arr[10] == (long)(NUM_PUSHES - 10) * 3 && arr[20] == -5,
+            "Mapped array has the wrong values.");
+    pak_larr_free(&arr);
+
+    // Element sizes must match
+    pak_test_assert(!pak_iarr_map_file(PATH, PAK_ARR_MAP_READ), "Mapped with the wrong type.");
+    pak_test_assert(!pak_larr_map_file("/tmp/pak_arr_map_test.missing", PAK_ARR_MAP_READ),
+            "Mapped a missing file.");
+
+    remove(PATH);
+#endif
+
+    return NULL;
+}
+
+static void arr_swap32(unsigned char *b)
+{
+    unsigned char t;
+    t = b[0]; b[0] = b[3]; b[3] = t;
+    t = b[1]; b[1] = b[2]; b[2] = t;
+}
+
+// Test binary snapshots, including ones from the other endianness
+char *pak_arr_io_test()
+{
+    static const int NUM_VALS = 1000000;
+    unsigned char raw[24 + 4 * 16];
+    int i;
+
+    FILE *f = tmpfile();
+    pak_test_assert(f, "Failed to open temporary file.");
+
+    pak_farr vals = pak_farr_new(NUM_VALS);
+    pak_iarr ints = pak_iarr_new(16);
+    pak_sarr strs = pak_sarr_new(4);
+
+    for (i = 0; i < NUM_VALS; i++)
+        pak_farr_push(&vals, i * 0.5f);
+    for (i = 0; i < 16; i++)
+        pak_iarr_push(&ints, i * 1000 - 3);
+
+    pak_sarr_push(&strs, "hello");
+    pak_sarr_push(&strs, "");
+    pak_sarr_push(&strs, NULL);
+    pak_sarr_push(&strs, "world");
+
+    // Several arrays one after the other
+    pak_test_assert(pak_arr_write(f, vals) == 0, "Failed to write floats.");
+    pak_test_assert(pak_sarr_write(f, strs) == 0, "Failed to write strings.");
+    pak_test_assert(pak_arr_write(f, ints) == 0, "Failed to write ints.");
+    rewind(f);
+
+    float *fin = pak_arr_read(float, f);
+    pak_test_assert(fin && pak_arr_count(fin) == NUM_VALS, "Failed to read floats.");
+    pak_test_assert(memcmp(fin, vals, sizeof(float) * NUM_VALS) == 0, "Read back the wrong floats.");
+
+    pak_sarr sin = pak_sarr_read(f);
+    pak_test_assert(sin && pak_sarr_count(sin) == 4, "Failed to read strings.");
+    pak_test_assert(strcmp(sin[0], "hello") == 0 && strcmp(sin[1], "") == 0 && !sin[2]
+            && strcmp(sin[3], "world") == 0, "Read back the wrong strings.");
+
+    // Element sizes must match
+    long pos = ftell(f);
+    pak_test_assert(!pak_arr_read(double, f), "Read ints as doubles.");
+    fseek(f, pos, SEEK_SET);
+
+    pak_iarr iin = pak_arr_read(int, f);
+    pak_test_assert(iin && memcmp(iin, ints, sizeof(int) * 16) == 0, "Read back the wrong ints.");
+    pak_test_assert(!pak_arr_read(int, f), "Read past the last array.");
+
+    // Swap every field of the int array and its elements by hand
+    fseek(f, pos, SEEK_SET);
+    pak_test_assert(fread(raw, 1, sizeof(raw), f) == sizeof(raw), "Failed to read raw ints.");
+
+    for (i = 4; i < 16; i += 4)
+        arr_swap32(raw + i);
+    for (i = 0; i < 4; i++) {
+        unsigned char t = raw[16 + i];
+        raw[16 + i] = raw[23 - i];
+        raw[23 - i] = t;
+    }
+    for (i = 24; i < (int)sizeof(raw); i += 4)
+        arr_swap32(raw + i);
+
+    rewind(f);
+    fwrite(raw, 1, sizeof(raw), f);
+    rewind(f);
+
+    pak_iarr swapped = pak_arr_read(int, f);
+    pak_test_assert(swapped && memcmp(swapped, ints, sizeof(int) * 16) == 0,
+            "Failed to read a byte swapped array.");
+
+    fclose(f);
+
+    // A count far past the end of the stream fails without allocating for it
+    uint64_t huge = (uint64_t)PAK_SIZE_MAX;
+
+    f = tmpfile();
+    pak_test_assert(f, "Failed to open temporary file.");
+    pak_test_assert(pak_arr_write(f, ints) == 0 && pak_sarr_write(f, strs) == 0,
+            "Failed to write arrays.");
+
+    fseek(f, 16, SEEK_SET);
+    fwrite(&huge, sizeof(huge), 1, f);
+    fseek(f, 24 + 16 * sizeof(int) + 16, SEEK_SET);
+    fwrite(&huge, sizeof(huge), 1, f);
+
+    rewind(f);
+    pak_test_assert(!pak_arr_read(int, f), "Read an array longer than its file.");
+    fseek(f, 24 + 16 * sizeof(int), SEEK_SET);
+    pak_test_assert(!pak_sarr_read(f), "Read a string array longer than its file.");
+
+    // Same for a string claiming to be longer than the file
+    uint32_t long_len = 0xFFFFFFF0;
+
+    rewind(f);
+    pak_test_assert(pak_sarr_write(f, strs) == 0, "Failed to write strings.");
+    fseek(f, 24, SEEK_SET);
+    fwrite(&long_len, sizeof(long_len), 1, f);
+
+    rewind(f);
+    pak_test_assert(!pak_sarr_read(f), "Read a string longer than its file.");
+
+    fclose(f);
+
+    for (i = 0; i < pak_sarr_count(sin); i++)
+        free(sin[i]);
+
+    pak_farr_free(&vals);
+    pak_farr_free(&fin);
+    pak_iarr_free(&ints);
+    pak_iarr_free(&iin);
+    pak_iarr_free(&swapped);
+    pak_sarr_free(&strs);
+    pak_sarr_free(&sin);
+
+    return NULL;
+}
+
+// A push as written by hand, doubling from the same start as GeoArray
+struct hand_array { int *data; pak_size count, max; };
+
+static int hand_push(struct hand_array *a, int val)
+{
+    if (a->count >= a->max) {
+        int *data = realloc(a->data, sizeof(*data) * a->max * 2);
+        if (!data)
+            return -1;
+        a->data = data;
+        a->max *= 2;
+    }
+
+    a->data[a->count++] = val;
+    return 0;
+}
+
+// Compare the typed push against a hand written one, the untyped one and raw stores
+char *pak_arr_push_bench_test()
+{
+    static const int NUM_PUSHES = 10000000;
+    double raw_sec, hand_sec, typed_sec;
+    clock_t begin;
+    int i;
+
+    int *raw = malloc(sizeof(*raw) * NUM_PUSHES);
+    pak_test_assert(raw, "Failed to allocate raw array.");
+
+    begin = clock();
+    for (i = 0; i < NUM_PUSHES; i++)
+        raw[i] = i;
+    raw_sec = (double)(clock() - begin)/CLOCKS_PER_SEC;
+
+    // Unlike the raw stores, pushes can not be vectorized, since every one may realloc
+    struct hand_array hand = { malloc(sizeof(int) * 16), 0, 16 };
+    pak_test_assert(hand.data, "Failed to allocate hand written array.");
+
+    begin = clock();
+    for (i = 0; i < NUM_PUSHES; i++)
+        hand_push(&hand, i);
+    hand_sec = (double)(clock() - begin)/CLOCKS_PER_SEC;
+
+    GeoArray arr = GeoArray_new(16);
+    pak_test_assert(arr, "Failed to create array.");
+
+    begin = clock();
+    for (i = 0; i < NUM_PUSHES; i++)
+        GeoArray_push(&arr, i);
+    typed_sec = (double)(clock() - begin)/CLOCKS_PER_SEC;
+
+    // Only printed, timings are too noisy to fail the suite on
+    pak_test_debug("%d stores: %lf sec raw, %lf sec hand written push, %lf sec typed push",
+            NUM_PUSHES, raw_sec, hand_sec, typed_sec);
+
+    pak_test_assert(memcmp(hand.data, raw, sizeof(*raw) * NUM_PUSHES) == 0,
+            "Hand written push stored the wrong values.");
+    free(hand.data);
+
+    pak_test_assert(memcmp(arr, raw, sizeof(*raw) * NUM_PUSHES) == 0, "Typed push stored the wrong values.");
+    pak_test_assert(*GeoArray_back(arr) == NUM_PUSHES - 1, "Back returned the wrong value.");
+
+    while (GeoArray_count(arr) > 0)
+        GeoArray_pop(&arr);
+
+    pak_test_assert(!GeoArray_back(arr), "Back of an empty array should be NULL.");
+
+    begin = clock();
+    for (i = 0; i < NUM_PUSHES; i++)
+        pak_arr_push(&arr, i);
+    pak_test_debug("Untyped push: %d pushes in %lf sec", NUM_PUSHES,
+            (double)(clock() - begin)/CLOCKS_PER_SEC);
+
+    GeoArray_free(&arr);
+    free(raw);
+
+    return NULL;
+}
+
+int arr_int_cmp(const void *a, const void *b)
+{
+    int x = *(const int *) a;
+    int y = *(const int *) b;
+    return (x > y) - (x < y);
+}
+
+// Test introsort and radix sort against qsort
+char *pak_arr_sort_test()
+{
+    static const int NUM_VALS = 1000000;
+    clock_t begin;
+    int i;
+
+    pak_iarr a = pak_iarr_new(NUM_VALS);
+    pak_iarr b = pak_iarr_new(NUM_VALS);
+    pak_iarr c = pak_iarr_new(NUM_VALS);
+    pak_test_assert(a && b && c, "Failed to create arrays.");
+
+    srand(1234);
+    for (i = 0; i < NUM_VALS; i++) {
+        int v = rand() - RAND_MAX/2;
+        pak_iarr_push(&a, v);
+    }
+
+    pak_iarr_extend(&b, a);
+    pak_iarr_extend(&c, a);
+
+    begin = clock();
+    pak_arr_sort(a, arr_int_cmp);
+    pak_test_debug("qsort: %d ints in %lf sec", NUM_VALS, (double)(clock() - begin)/CLOCKS_PER_SEC);
+
+    begin = clock();
+    pak_iarr_sort(b);
+    pak_test_debug("Introsort: %d ints in %lf sec", NUM_VALS, (double)(clock() - begin)/CLOCKS_PER_SEC);
+
+    begin = clock();
+    pak_test_assert(pak_iarr_radix_sort(c) == 0, "Failed to radix sort.");
+    pak_test_debug("Radix sort: %d ints in %lf sec", NUM_VALS, (double)(clock() - begin)/CLOCKS_PER_SEC);
+
+    pak_test_assert(memcmp(a, b, sizeof(int) * NUM_VALS) == 0, "Introsort does not match qsort.");
+    pak_test_assert(memcmp(a, c, sizeof(int) * NUM_VALS) == 0, "Radix sort does not match qsort.");
+
+    // Already sorted, reversed and constant inputs
+    pak_iarr_sort(b);
+    pak_test_assert(memcmp(a, b, sizeof(int) * NUM_VALS) == 0, "Introsort broke a sorted array.");
+
+    for (i = 0; i < NUM_VALS; i++)
+        b[i] = NUM_VALS - i;
+    pak_iarr_sort(b);
+    for (i = 0; i < NUM_VALS; i++)
+        pak_test_assert(b[i] == i + 1, "Introsort failed on a reversed array.");
+
+    for (i = 0; i < NUM_VALS; i++)
+        b[i] = 7;
+    pak_iarr_sort(b);
+    pak_test_assert(b[0] == 7 && b[NUM_VALS - 1] == 7, "Introsort failed on a constant array.");
+
+    pak_iarr_free(&a);
+    pak_iarr_free(&b);
+    pak_iarr_free(&c);
+
+    // Radix sorting handles negative numbers of every type
+    pak_larr l = pak_larr_new(16);
+    pak_farr f = pak_farr_new(16);
+    pak_darr d = pak_darr_new(16);
+
+    for (i = 0; i < 1000; i++) {
+        int v = (rand() % 2001) - 1000;
+        pak_larr_push(&l, (long)v * 100000);
+        pak_farr_push(&f, v / 7.0f);
+        pak_darr_push(&d, v / 3.0);
+    }
+
+    pak_test_assert(pak_larr_radix_sort(l) == 0, "Failed to radix sort longs.");
+    pak_test_assert(pak_farr_radix_sort(f) == 0, "Failed to radix sort floats.");
+    pak_test_assert(pak_darr_radix_sort(d) == 0, "Failed to radix sort doubles.");
+
+    for (i = 1; i < 1000; i++) {
+        pak_test_assert(l[i - 1] <= l[i], "Longs are out of order at %d.", i);
+        pak_test_assert(f[i - 1] <= f[i], "Floats are out of order at %d.", i);
+        pak_test_assert(d[i - 1] <= d[i], "Doubles are out of order at %d.", i);
+    }
+
+    pak_larr_free(&l);
+    pak_farr_free(&f);
+    pak_darr_free(&d);
+
+    // Custom comparators
+    PairArray pairs = PairArray_new(16);
+
+    for (i = 0; i < 1000; i++) {
+        arr_pair p = { rand() % 50, i };
+        PairArray_push(&pairs, p);
+    }
+
+    PairArray_sort(pairs);
+    for (i = 1; i < 1000; i++)
+        pak_test_assert(pairs[i - 1].key <= pairs[i].key, "Pairs are out of order at %d.", i);
+
+    PairArray_free(&pairs);
+
+    return NULL;
+}
+
+static double arr_wall_clock()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Test parallel sorting against the serial sort, with different thread counts
+char *pak_arr_parallel_sort_test()
+{
+    static const int NUM_VALS = 4000000;
+    static const int THREADS[] = { 1, 2, 3, 4, 8, 16 };
+    int i, t;
+
+    pak_iarr vals = pak_iarr_new(NUM_VALS);
+    pak_iarr expect = pak_iarr_new(NUM_VALS);
+    pak_iarr arr = pak_iarr_new(NUM_VALS);
+    pak_test_assert(vals && expect && arr, "Failed to create arrays.");
+
+    srand(4321);
+    for (i = 0; i < NUM_VALS; i++) {
+        int v = rand() % 100000;
+        pak_iarr_push(&vals, v);
+    }
+
+    pak_iarr_extend(&expect, vals);
+    pak_iarr_sort(expect);
+
+    for (t = 0; t < (int)(sizeof(THREADS)/sizeof(*THREADS)); t++) {
+        double begin;
+
+        pak_iarr_erase_range(&arr, 0, pak_iarr_count(arr));
+        pak_iarr_extend(&arr, vals);
+
+        begin = arr_wall_clock();
+        pak_test_assert(pak_arr_parallel_sort(arr, arr_int_cmp, THREADS[t]) == 0,
+                "Failed to sort with %d threads.", THREADS[t]);
+        pak_test_debug("Parallel sort: %d ints on %d thread(s) in %lf sec", NUM_VALS, THREADS[t],
+                arr_wall_clock() - begin);
+
+        pak_test_assert(pak_iarr_count(arr) == NUM_VALS, "Parallel sort changed the count.");
+        pak_test_assert(memcmp(arr, expect, sizeof(int) * NUM_VALS) == 0,
+                "Parallel sort with %d threads does not match the serial sort.", THREADS[t]);
+    }
+
+    pak_iarr_free(&vals);
+    pak_iarr_free(&expect);
+    pak_iarr_free(&arr);
+
+    return NULL;
+}
+
+// Test every search against a linear scan, on sizes around the power of two edges
+char *pak_arr_search_test()
+{
+    int n, key, i;
+
+    for (n = 0; n <= 70; n++) {
+        pak_iarr arr = pak_iarr_new(16);
+        pak_iarr eyt = NULL;
+
+        // Every value appears once or twice
+        for (i = 0; i < n; i++)
+            pak_iarr_push(&arr, 2 * (i - i / 3));
+
+        eyt = pak_iarr_eytzinger(arr);
+        pak_test_assert(eyt && pak_iarr_count(eyt) == n, "Failed to build Eytzinger array.");
+
+        for (key = -1; key <= 2 * n + 1; key++) {
+            int lower = 0, upper = 0;
+            pak_size first, last, e;
+
+            while (lower < n && arr[lower] < key)
+                lower++;
+            while (upper < n && arr[upper] <= key)
+                upper++;
+
+            pak_test_assert(pak_iarr_lower_bound(arr, key) == lower,
+                    "Wrong lower bound of %d in %d elements.", key, n);
+            pak_test_assert(pak_iarr_upper_bound(arr, key) == upper,
+                    "Wrong upper bound of %d in %d elements.", key, n);
+            pak_test_assert(pak_iarr_lower_bound_branchless(arr, key) == lower,
+                    "Wrong branchless lower bound of %d in %d elements.", key, n);
+            pak_test_assert(pak_iarr_equal_range(arr, key, &first, &last) == upper - lower
+                    && first == lower && last == upper,
+                    "Wrong equal range of %d in %d elements.", key, n);
+            pak_test_assert(pak_iarr_contains(arr, key) == (upper > lower),
+                    "Wrong contains of %d in %d elements.", key, n);
+
+            e = pak_iarr_eytzinger_lower_bound(eyt, key);
+            if (lower == n) {
+                pak_test_assert(e == -1, "Eytzinger found %d past the end.", key);
+            } else {
+                pak_test_assert(e >= 0 && e < n && eyt[e] == arr[lower],
+                        "Wrong Eytzinger lower bound of %d in %d elements.", key, n);
+            }
+        }
+
+        pak_iarr_free(&arr);
+        pak_iarr_free(&eyt);
+    }
+
+    // Custom comparators, only keys are compared
+    PairArray pairs = PairArray_new(16);
+
+    for (i = 0; i < 100; i++) {
+        arr_pair p = { i / 10, i };
+        PairArray_push(&pairs, p);
+    }
+
+    arr_pair k = { 4, -1 };
+    pak_size first, last;
+    pak_test_assert(PairArray_equal_range(pairs, k, &first, &last) == 10 && first == 40,
+            "Wrong equal range of pairs.");
+    k.key = 10;
+    pak_test_assert(!PairArray_contains(pairs, k), "Found a missing pair.");
+
+    PairArray_free(&pairs);
+
+    return NULL;
+}
+
 char *pak_arr_test()
 {
     pak_test_run(pak_arr_raw_test);
     pak_test_run(pak_arr_typesafe_test);
     pak_test_run(pak_arr_gc_test);
+    pak_test_run(pak_arr_gc_range_test);
+    pak_test_run(pak_arr_growth_test);
+    pak_test_run(pak_arr_size_test);
+    pak_test_run(pak_arr_reserve_test);
+    pak_test_run(pak_arr_bulk_test);
+    pak_test_run(pak_arr_erase_test);
+    pak_test_run(pak_arr_aligned_test);
+    pak_test_run(pak_arr_alloc_test);
+    pak_test_run(pak_arr_buf_test);
+    pak_test_run(pak_arr_soa_test);
+    pak_test_run(pak_arr_map_test);
+    pak_test_run(pak_arr_io_test);
+    pak_test_run(pak_arr_push_bench_test);
+    pak_test_run(pak_arr_sort_test);
+    pak_test_run(pak_arr_parallel_sort_test);
+    pak_test_run(pak_arr_search_test);
 
     return NULL;
 }
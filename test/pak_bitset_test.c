@@ -0,0 +1,173 @@
+#include "pak_test.h"
+#include "pak_bitset_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pak.h>
+
+// Test single bits, filling and resizing across word boundaries
+char *pak_bitset_basic_test()
+{
+    int i;
+
+    pak_bits bits = pak_bits_new(130);
+    pak_test_assert(bits, "Failed to create bit array.");
+    pak_test_assert(pak_bits_size(bits) == 130, "Wrong bit array size.");
+    pak_test_assert(pak_bits_count(bits) == 0, "New bits are not cleared.");
+
+    for (i = 0; i < 130; i += 3)
+        pak_bits_set(bits, i);
+
+    for (i = 0; i < 130; i++)
+        pak_test_assert(pak_bits_test(bits, i) == (i % 3 == 0), "Wrong value of bit %d.", i);
+    pak_test_assert(pak_bits_count(bits) == 44, "Counted %d bits.", (int)pak_bits_count(bits));
+
+    pak_bits_clear(bits, 129);
+    pak_test_assert(!pak_bits_test(bits, 129) && pak_bits_count(bits) == 43, "Failed to clear a bit.");
+
+    // Filling never sets the bits past the end of the last word
+    pak_bits_fill(bits, 1);
+    pak_test_assert(pak_bits_count(bits) == 130, "Filled %d bits.", (int)pak_bits_count(bits));
+
+    pak_test_assert(pak_bits_resize(bits, 100) == 0, "Failed to shrink bit array.");
+    pak_test_assert(pak_bits_count(bits) == 100, "Shrinking kept %d bits.", (int)pak_bits_count(bits));
+
+    pak_test_assert(pak_bits_resize(bits, 1000) == 0, "Failed to grow bit array.");
+    pak_test_assert(pak_bits_count(bits) == 100, "Growing set %d bits.", (int)pak_bits_count(bits));
+    pak_test_assert(!pak_bits_test(bits, 100) && !pak_bits_test(bits, 999), "New bits are not cleared.");
+
+    pak_bits_fill(bits, 0);
+    pak_test_assert(pak_bits_count(bits) == 0, "Failed to clear all bits.");
+
+    pak_bits_free(&bits);
+    pak_test_assert(!bits, "Bit array was not set to NULL.");
+
+    bits = pak_bits_new(0);
+    pak_test_assert(bits && pak_bits_find_next_set(bits, 0) == -1, "Empty bit array has set bits.");
+    pak_bits_free(&bits);
+
+    return NULL;
+}
+
+// Test the set operations, rank and find_next_set against plain bytes
+char *pak_bitset_ops_test()
+{
+    static const int NUM_BITS = 1000;
+    char a[1000], b[1000];
+    int i, n, rank;
+    pak_size j;
+
+    pak_bits x = pak_bits_new(NUM_BITS);
+    pak_bits y = pak_bits_new(NUM_BITS);
+    pak_bits z = pak_bits_new(NUM_BITS + 1);
+
+    srand(7);
+    for (i = 0; i < NUM_BITS; i++) {
+        a[i] = rand() % 4 == 0;
+        b[i] = rand() % 2 == 0;
+        if (a[i])
+            pak_bits_set(x, i);
+        if (b[i])
+            pak_bits_set(y, i);
+    }
+
+    // Rank is the number of set bits below the index
+    for (i = 0, rank = 0; i <= NUM_BITS; i++) {
+        pak_test_assert(pak_bits_rank(x, i) == rank, "Wrong rank at %d.", i);
+        if (i < NUM_BITS)
+            rank += a[i];
+    }
+
+    // Walking the set bits visits exactly the set bytes
+    for (j = pak_bits_find_next_set(x, 0), i = 0; j >= 0; j = pak_bits_find_next_set(x, j + 1)) {
+        while (!a[i])
+            i++;
+        pak_test_assert(j == i, "Found bit %d instead of %d.", (int)j, i);
+        i++;
+    }
+    for (; i < NUM_BITS; i++)
+        pak_test_assert(!a[i], "Missed bit %d.", i);
+
+    pak_test_assert(pak_bits_and(x, z) == -1, "Combined bit arrays of different sizes.");
+
+#define BITS_CHECK(OP, EXPR)                                                                \
+    do {                                                                                    \
+        pak_bits t = pak_bits_new(NUM_BITS);                                                \
+        pak_bits_or(t, x);                                                                  \
+        pak_test_assert(pak_bits_##OP(t, y) == 0, "Failed to " #OP " bit arrays.");         \
+        for (i = 0, n = 0; i < NUM_BITS; i++) {                                             \
+            pak_test_assert(pak_bits_test(t, i) == (EXPR), "Wrong " #OP " at %d.", i);      \
+            n += (EXPR);                                                                    \
+        }                                                                                   \
+        pak_test_assert(pak_bits_count(t) == n, "Wrong " #OP " count.");                    \
+        pak_bits_free(&t);                                                                  \
+    } while (0)
+
+    BITS_CHECK(and,    a[i] & b[i]);
+    BITS_CHECK(or,     a[i] | b[i]);
+    BITS_CHECK(xor,    a[i] ^ b[i]);
+    BITS_CHECK(andnot, a[i] & !b[i]);
+
+#undef BITS_CHECK
+
+    pak_bits_free(&x);
+    pak_bits_free(&y);
+    pak_bits_free(&z);
+
+    return NULL;
+}
+
+// Compare filtering a mask against the same flags kept as bytes
+char *pak_bitset_bench_test()
+{
+    static const int NUM_ROWS = 10000000;
+    pak_size i, set = 0;
+    clock_t begin;
+
+    pak_bits mask = pak_bits_new(NUM_ROWS);
+    pak_bits keep = pak_bits_new(NUM_ROWS);
+    pak_carr bytes = pak_carr_new(NUM_ROWS);
+    pak_carr keep_bytes = pak_carr_new(NUM_ROWS);
+    pak_test_assert(mask && keep && bytes && keep_bytes, "Failed to create masks.");
+
+    for (i = 0; i < NUM_ROWS; i++) {
+        int on = (i * 7) % 5 < 2, kept = i % 3 != 0;
+        pak_carr_push(&bytes, (char)on);
+        pak_carr_push(&keep_bytes, (char)kept);
+        if (on)
+            pak_bits_set(mask, i);
+        if (kept)
+            pak_bits_set(keep, i);
+    }
+
+    begin = clock();
+    for (i = 0; i < NUM_ROWS; i++) {
+        bytes[i] &= keep_bytes[i];
+        set += bytes[i];
+    }
+    pak_test_debug("Byte mask: %d rows in %lf sec", NUM_ROWS,
+            (double)(clock() - begin)/CLOCKS_PER_SEC);
+
+    begin = clock();
+    pak_bits_and(mask, keep);
+    pak_test_assert(pak_bits_count(mask) == set, "Bit mask disagrees with the byte mask.");
+    pak_test_debug("Bit mask: %d rows in %lf sec", NUM_ROWS,
+            (double)(clock() - begin)/CLOCKS_PER_SEC);
+
+    pak_bits_free(&mask);
+    pak_bits_free(&keep);
+    pak_carr_free(&bytes);
+    pak_carr_free(&keep_bytes);
+
+    return NULL;
+}
+
+char *pak_bitset_test()
+{
+    pak_test_run(pak_bitset_basic_test);
+    pak_test_run(pak_bitset_ops_test);
+    pak_test_run(pak_bitset_bench_test);
+
+    return NULL;
+}
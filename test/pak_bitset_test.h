@@ -0,0 +1,6 @@
+#ifndef PAK_BITSET_TEST_HEADER
+#define PAK_BITSET_TEST_HEADER
+
+char *pak_bitset_test();
+
+#endif // PAK_BITSET_TEST_HEADER
@@ -0,0 +1,178 @@
+#include "pak_test.h"
+#include "pak_deque_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pak.h>
+
+PAK_INIT_DEQUE(IntDeque, int);
+PAK_INIT_LIST(BenchList, int, (void));
+
+// Test both ends, wrapping around, and growing while wrapped
+char *pak_deque_basic_test()
+{
+    int i, v;
+
+    IntDeque dq = IntDeque_new(3);
+    pak_test_assert(dq, "Failed to create deque.");
+    pak_test_assert(IntDeque_max(dq) == 4, "Deque size is not a power of two.");
+
+    pak_test_assert(IntDeque_pop(dq, &v) != 0, "Popped from an empty deque.");
+    pak_test_assert(IntDeque_shift(dq, &v) != 0, "Shifted from an empty deque.");
+    pak_test_assert(!IntDeque_front(dq), "Empty deque has a front.");
+
+    // Walk the head all the way around the ring
+    IntDeque_push(dq, -1);
+    for (i = 0; i < 10; i++) {
+        IntDeque_push(dq, i);
+        IntDeque_shift(dq, &v);
+        pak_test_assert(v == i - 1, "Shifted the wrong value.");
+    }
+    pak_test_assert(IntDeque_max(dq) == 4, "Deque grew without filling up.");
+    IntDeque_clear(dq);
+
+    // Fill it wrapped, then grow it
+    for (i = 0; i < 3; i++)
+        IntDeque_push(dq, i);
+    for (i = 1; i <= 5; i++)
+        IntDeque_unshift(dq, -i);
+
+    pak_test_assert(IntDeque_count(dq) == 8 && IntDeque_max(dq) == 8, "Deque grew wrong.");
+    for (i = 0; i < 8; i++)
+        pak_test_assert(pak_deque_at(dq, i) == i - 5, "Deque out of order at %d.", i);
+
+    pak_test_assert(*IntDeque_front(dq) == -5 && *IntDeque_back(dq) == 2, "Wrong front or back.");
+    pak_test_assert(*IntDeque_get(dq, -2) == 1, "Negative index failed.");
+    pak_test_assert(!IntDeque_get(dq, 8) && !IntDeque_get(dq, -9), "Indexed out of bounds.");
+
+    pak_deque_at(dq, 0) = 42;
+    pak_test_assert(IntDeque_shift(dq, &v) == 0 && v == 42, "Assigning through pak_deque_at failed.");
+    pak_test_assert(IntDeque_pop(dq, &v) == 0 && v == 2, "Popped the wrong value.");
+    pak_test_assert(IntDeque_pop(dq, NULL) == 0 && IntDeque_count(dq) == 5, "Pop without out failed.");
+
+    pak_test_assert(IntDeque_reserve(dq, 100) == 0 && IntDeque_max(dq) == 128, "Failed to reserve.");
+    for (i = 0; i < 5; i++)
+        pak_test_assert(pak_deque_at(dq, i) == i - 4, "Reserve lost value at %d.", i);
+
+    // Reserving many times the size in one go, with the longer side before the wrap
+    IntDeque_clear(dq);
+    for (i = 0; i < 120; i++)
+        IntDeque_push(dq, i);
+    for (i = 0; i < 100; i++)
+        IntDeque_shift(dq, NULL);
+    for (i = 120; i < 200; i++)
+        IntDeque_push(dq, i);
+    pak_test_assert(IntDeque_reserve(dq, 5000) == 0 && IntDeque_max(dq) == 8192,
+            "Failed to reserve across the wrap.");
+    for (i = 0; i < 100; i++)
+        pak_test_assert(pak_deque_at(dq, i) == i + 100, "Wrapped reserve lost value at %d.", i);
+
+    IntDeque_free(&dq);
+    pak_test_assert(!dq, "Deque should be NULL after free.");
+
+    return NULL;
+}
+
+// Test random operations against a plain array with the front in the middle
+char *pak_deque_random_test()
+{
+    static const int NUM_OPS = 200000;
+    int *model = malloc(sizeof(int) * NUM_OPS * 2);
+    int first = NUM_OPS, last = NUM_OPS;
+    int i, v;
+
+    IntDeque dq = IntDeque_new(1);
+    pak_test_assert(model && dq, "Failed to create deque.");
+
+    srand(99);
+    for (i = 0; i < NUM_OPS; i++) {
+        switch (rand() % 5) {
+        case 0:
+        case 1:
+            IntDeque_push(dq, i);
+            model[last++] = i;
+            break;
+        case 2:
+            IntDeque_unshift(dq, i);
+            model[--first] = i;
+            break;
+        case 3:
+            if (last > first) {
+                pak_test_assert(IntDeque_pop(dq, &v) == 0 && v == model[--last],
+                        "Pop does not match at op %d.", i);
+            }
+            break;
+        default:
+            if (last > first) {
+                pak_test_assert(IntDeque_shift(dq, &v) == 0 && v == model[first++],
+                        "Shift does not match at op %d.", i);
+            }
+        }
+
+        pak_test_assert(IntDeque_count(dq) == last - first, "Count does not match at op %d.", i);
+    }
+
+    for (i = first; i < last; i++)
+        pak_test_assert(pak_deque_at(dq, i - first) == model[i], "Deque does not match at %d.", i);
+
+    IntDeque_free(&dq);
+    free(model);
+
+    return NULL;
+}
+
+// Compare a FIFO on a deque against one on a list
+char *pak_deque_fifo_bench_test()
+{
+    static const int NUM_ROUNDS = 1000;
+    static const int QUEUE_LEN = 1000;
+    clock_t begin;
+    long sum_dq = 0, sum_list = 0;
+    int i, j, v = 0;
+
+    IntDeque dq = IntDeque_new(QUEUE_LEN);
+    BenchList list = BenchList_new();
+    pak_test_assert(dq && list, "Failed to create queues.");
+
+    begin = clock();
+    for (i = 0; i < NUM_ROUNDS; i++) {
+        for (j = 0; j < QUEUE_LEN; j++)
+            IntDeque_push(dq, j);
+        for (j = 0; j < QUEUE_LEN; j++) {
+            IntDeque_shift(dq, &v);
+            sum_dq += v;
+        }
+    }
+    pak_test_debug("Deque FIFO: %d ops in %lf sec", NUM_ROUNDS * QUEUE_LEN,
+            (double)(clock() - begin)/CLOCKS_PER_SEC);
+
+    begin = clock();
+    for (i = 0; i < NUM_ROUNDS; i++) {
+        for (j = 0; j < QUEUE_LEN; j++)
+            BenchList_push(list, j);
+        for (j = 0; j < QUEUE_LEN; j++) {
+            sum_list += list->first->data;
+            BenchList_shift(list);
+        }
+    }
+    pak_test_debug("List FIFO: %d ops in %lf sec", NUM_ROUNDS * QUEUE_LEN,
+            (double)(clock() - begin)/CLOCKS_PER_SEC);
+
+    pak_test_assert(sum_dq == sum_list, "Deque and list disagree.");
+    pak_test_assert(IntDeque_max(dq) == 1024, "Steady state FIFO should not grow.");
+
+    IntDeque_free(&dq);
+    BenchList_free(&list);
+
+    return NULL;
+}
+
+char *pak_deque_test()
+{
+    pak_test_run(pak_deque_basic_test);
+    pak_test_run(pak_deque_random_test);
+    pak_test_run(pak_deque_fifo_bench_test);
+
+    return NULL;
+}
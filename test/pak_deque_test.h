@@ -0,0 +1,6 @@
+#ifndef PAK_DEQUE_TEST_HEADER
+#define PAK_DEQUE_TEST_HEADER
+
+char *pak_deque_test();
+
+#endif // PAK_DEQUE_TEST_HEADER
@@ -1,136 +1,673 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
 #include "pak_test.h"
 #include "pak_list_test.h"
 
 #include <stdlib.h>
+#include <time.h>
 #include <pak.h>
 
-PAK_INIT_LIST(IntList, int, NULL)
+PAK_INIT_LIST(IntList, int, (void))
 
-void list_gc(void *e)
+void list_gc(int *val)
 {
-    int *val = *(int **) e;
     free(val);
 }
 PAK_INIT_LIST(GCList, int*, list_gc)
 
-char *pak_list_raw_test()
+typedef struct { int key, seq; } Pair;
+#define pair_less(A, B) ((A).key < (B).key)
+#define int_less(A, B) ((A) < (B))
+PAK_INIT_LIST(PairList, Pair, (void))
+PAK_INIT_LIST_SORT(PairList, Pair, pair_less)
+PAK_INIT_LIST_SORT(IntList, int, int_less)
+
+PAK_INIT_ULIST(IntUList, int, (void))
+PAK_INIT_ULIST(GCUList, int*, list_gc)
+
+struct job {
+    int id;
+    pak_ilist_link queue;
+    pak_ilist_link owner;
+};
+PAK_INIT_ILIST(JobQueue, struct job, queue)
+PAK_INIT_ILIST(JobList, struct job, owner)
+
+// Test pushing, popping, unshifting, shifting and indexing
+char *pak_list_typesafe_test()
 {
     static const int NUM_PUSHES = 100000;
-    int i;
+    int i, sum = 0;
 
-    pak_list *list = pak_list_new(int);
-    pak_test_assert(list, "Failed to create PAK list");
+    IntList list = IntList_new();
+    pak_test_assert(list, "Failed to create typesafe list.");
 
     /*
        Pushing and popping
     */
 
     for (i = 0; i < NUM_PUSHES; i++)
-        pak_list_push(list, i);
+        IntList_push(list, i);
+
+    // Test list traversal, which visits every node
+    IntList_node *n;
+    pak_list_foreach(list, n) {
+        if (n->data == NUM_PUSHES/2)
+            pak_test_debug("Hit list midpoint %d!", n->data);
+        sum++;
+    }
+    pak_test_assert(sum == NUM_PUSHES, "Traversal visited %d nodes.", sum);
+
+    pak_test_assert(IntList_get(list, 0)->data == 0, "Wrong first node.");
+    pak_test_assert(IntList_get(list, 10)->data == 10, "Wrong node from the front.");
+    pak_test_assert(IntList_get(list, NUM_PUSHES - 10)->data == NUM_PUSHES - 10,
+            "Wrong node from the back.");
+    pak_test_assert(IntList_get(list, -1)->data == NUM_PUSHES - 1, "Wrong last node.");
+    pak_test_assert(!IntList_get(list, NUM_PUSHES) && !IntList_get(list, -NUM_PUSHES - 1),
+            "Got past the ends.");
 
     for (i = 0; i < NUM_PUSHES; i++)
-        pak_list_pop(list);
+        IntList_pop(list);
 
-    pak_test_debug("Performed %d pushes and pops on PAK list.", NUM_PUSHES);
+    pak_test_assert(list->count == 0 && !list->first && !list->last, "List is not empty.");
+    pak_test_debug("Performed %d pushes and pops on typesafe list.", NUM_PUSHES);
 
     /*
         Unshifting and shifting
     */
 
     for (i = 0; i < NUM_PUSHES; i++)
-        pak_list_unshift(list, i);
+        IntList_unshift(list, i);
+
+    pak_test_assert(list->first->data == NUM_PUSHES - 1 && list->last->data == 0,
+            "Unshifted in the wrong order.");
 
     for (i = 0; i < NUM_PUSHES; i++)
-        pak_list_shift(list);
+        IntList_shift(list);
 
     pak_test_debug("Performed %d unshifts and shifts on PAK list.", NUM_PUSHES);
 
-    // Test to see if pak_list_free will clear out the list
+    // Test to see if the free will clear out the list
     for (i = 0; i < NUM_PUSHES; i++)
-        pak_list_push(list, i);
+        IntList_push(list, i);
 
-    pak_list_free(&list);
+    IntList_free(&list);
     pak_test_assert(!list, "List should be NULL after free.");
 
     return NULL;
 }
 
-char *pak_list_typesafe_test()
+char *pak_list_gc_test()
 {
-    static const int NUM_PUSHES = 100000;
+    static const int NUM_PUSHES = 1000;
+    int i;
+
+    GCList list = GCList_new();
+    pak_test_assert(list, "Failed to create GC list.");
+
+    for (i = 0; i < NUM_PUSHES; i++) {
+        int *p = malloc(sizeof(*p));
+        *p = i;
+
+        GCList_push(list, p);
+    }
+
+    GCList_pop(list);
+    GCList_shift(list);
+    GCList_free(&list);
+
+    return NULL;
+}
+
+// Test that nodes are recycled, and shared between lists of one pool
+char *pak_list_pool_test()
+{
+    IntList_node *node;
     int i;
 
     IntList list = IntList_new();
-    pak_test_assert(list, "Failed to create typesafe list.");
+    pak_test_assert(list, "Failed to create list.");
 
-    /*
-       Pushing and popping
-    */
+    IntList_push(list, 1);
+    node = list->last;
+    IntList_pop(list);
+    IntList_push(list, 2);
+    pak_test_assert(list->last == node, "Popped node was not reused.");
 
-    for (i = 0; i < NUM_PUSHES; i++)
+    // A slab is handed out node by node before the next one is allocated
+    for (i = 1; i < PAK_LIST_SLAB_MIN; i++)
         IntList_push(list, i);
+    pak_test_assert(list->pool->slabs && !list->pool->slabs->prev, "Allocated a second slab.");
+    IntList_push(list, 0);
+    pak_test_assert(list->pool->slabs->prev, "Did not allocate a second slab.");
+    IntList_free(&list);
 
-    // Test list traversal
-    IntList_node n;
-    pak_list_foreach(list, n) {
-        int d = IntList_data(n);
+    pak_pool pool = pak_pool_new(sizeof(IntList_node), NULL);
+    pak_test_assert(pool, "Failed to create pool.");
+
+    IntList a = IntList_new_pool(pool);
+    IntList b = IntList_new_pool(pool);
+    pak_test_assert(a && b && pool->refs == 3, "Failed to share pool.");
+    pak_pool_free(&pool);
+    pak_test_assert(!pool, "Pool should be NULL after free.");
 
-        if (d == NUM_PUSHES/2)
-            pak_test_debug("Hit list midpoint %d!", d);
+    for (i = 0; i < 100; i++)
+        IntList_push(a, i);
+
+    // Freeing a list on a shared pool returns its nodes for the other lists
+    node = a->last;
+    pool = a->pool;
+    IntList_free(&a);
+    pak_test_assert(pool->refs == 1, "Freed list kept its reference.");
+
+    IntList_push(b, 0);
+    pak_test_assert(b->last == node, "Node of a freed list was not reused.");
+    pak_test_assert(IntList_new_pool(NULL) == NULL, "Created a list without a pool.");
+
+    IntList_free(&b);
+
+    return NULL;
+}
+
+// Check a list's links both ways, and that it holds "n" values counting up from "first"
+static int list_check(IntList list, int first, int n)
+{
+    IntList_node *node, *prev = NULL;
+    int i = 0;
+
+    pak_list_foreach(list, node) {
+        if (node->prev != prev || node->data != first + i)
+            return 0;
+        prev = node;
+        i++;
     }
 
-    for (i = 0; i < NUM_PUSHES; i++)
-        IntList_pop(list);
+    return i == n && list->count == n && list->last == prev;
+}
 
-    pak_test_debug("Performed %d pushes and pops on typesafe list.", NUM_PUSHES);
+// Test relinking nodes between lists of one pool
+char *pak_list_splice_test()
+{
+    char *fresh;
+    int i;
 
-    /*
-        Unshifting and shifting
-    */
+    pak_pool pool = pak_pool_new(sizeof(IntList_node), NULL);
+    IntList a = IntList_new_pool(pool);
+    IntList b = IntList_new_pool(pool);
+    IntList other = IntList_new();
+    pak_pool_free(&pool);
+    pak_test_assert(a && b && other, "Failed to create lists.");
+
+    for (i = 0; i < 10; i++)
+        IntList_push(a, i);
+    for (i = 10; i < 20; i++)
+        IntList_push(b, i);
+
+    // Relinking never takes nodes from the pool or gives them back
+    pool = a->pool;
+    fresh = pool->fresh;
+    pak_test_assert(IntList_concat(a, b) == 0, "Failed to concatenate.");
+    pak_test_assert(list_check(a, 0, 20) && list_check(b, 0, 0), "Wrong concatenation.");
+
+    IntList c = IntList_split_at(a, IntList_get(a, 15));
+    pak_test_assert(c && list_check(a, 0, 15) && list_check(c, 15, 5), "Wrong split near the end.");
+    pak_test_assert(pool->fresh == fresh && !pool->spare, "Relinking went through the pool.");
+    IntList_free(&c);
+
+    c = IntList_split_at(a, IntList_get(a, 2));
+    pak_test_assert(c && list_check(a, 0, 2) && list_check(c, 2, 13), "Wrong split near the front.");
+
+    pak_test_assert(IntList_splice(a, c) == 0 && list_check(a, 0, 15) && c->count == 0,
+            "Failed to splice back onto the end.");
+    IntList_free(&c);
+
+    c = IntList_split_at(a, a->first);
+    pak_test_assert(c && list_check(a, 0, 0) && list_check(c, 0, 15), "Wrong split of everything.");
+
+    // Splicing to the front and into the middle
+    IntList_push(b, 100);
+    IntList_splice_after(c, NULL, b);
+    pak_test_assert(c->first->data == 100 && list_check(b, 0, 0), "Failed to splice at the front.");
+    IntList_shift(c);
+
+    for (i = 0; i < 5; i++)
+        IntList_move_node(a, c, c->first);
+    pak_test_assert(list_check(a, 0, 5) && list_check(c, 5, 10), "Failed to move nodes.");
+    IntList_move_node(b, c, c->last);
+    IntList_move_node(b, c, IntList_get(c, 4));
+    pak_test_assert(b->count == 2 && b->first->data == 14 && b->last->data == 9 && c->count == 8,
+            "Failed to move nodes from the back and the middle.");
+
+    IntList_free(&b);
+    for (i = 0; i < 8; i++)
+        IntList_move_node(a, c, c->first);
+    pak_test_assert(a->count == 13 && c->count == 0 && !c->first && !c->last,
+            "Failed to empty by moving.");
+    pak_test_assert(IntList_move_node(a, c, a->first) != 0, "Moved a node out of an empty list.");
+
+    pak_test_assert(IntList_concat(a, a) != 0, "Concatenated a list to itself.");
+
+    IntList_free(&a);
+    IntList_free(&c);
+    IntList_free(&other);
 
-    for (i = 0; i < NUM_PUSHES; i++)
-        IntList_unshift(list, i);
+    return NULL;
+}
 
-    for (i = 0; i < NUM_PUSHES; i++)
-        IntList_shift(list);
+// Test moving nodes between lists with pools of their own, which copies them
+char *pak_list_splice_pools_test()
+{
+    IntList_node *node;
+    int i;
 
-    pak_test_debug("Performed %d unshifts and shifts on PAK list.", NUM_PUSHES);
+    IntList a = IntList_new();
+    IntList b = IntList_new();
+    pak_test_assert(a && b && a->pool != b->pool, "Failed to create lists.");
 
-    // Test to see if pak_list_free will clear out the list
-    for (i = 0; i < NUM_PUSHES; i++)
-        IntList_push(list, i);
+    for (i = 0; i < 3; i++)
+        IntList_push(a, i);
+    for (i = 3; i < 100; i++)
+        IntList_push(b, i);
+
+    pak_test_assert(IntList_splice(a, b) == 0 && list_check(a, 0, 100) && list_check(b, 0, 0),
+            "Failed to splice between pools.");
+
+    // The source list gets its nodes back for its next push
+    node = (IntList_node *)b->pool->spare;
+    pak_test_assert(node, "Copied nodes were not given back.");
+    IntList_push(b, 1000);
+    pak_test_assert(b->first == node, "Given back node was not reused.");
+    IntList_pop(b);
+
+    for (i = 0; i < 5; i++)
+        IntList_move_node(b, a, a->last);
+    pak_test_assert(list_check(a, 0, 95) && b->count == 5 && b->first->data == 99,
+            "Failed to move nodes between pools.");
+
+    IntList_pop(b);
+    IntList_pop(b);
+    IntList_pop(b);
+    pak_test_assert(IntList_splice_after(a, IntList_get(a, 94), b) == 0 && a->count == 97 &&
+            a->last->data == 98 && IntList_get(a, -2)->data == 99, "Failed to splice after a node.");
+
+    IntList c = IntList_split_at(a, IntList_get(a, 50));
+    pak_test_assert(c && c->pool == a->pool && a->count == 50 && c->count == 47, "Failed to split.");
+
+    IntList_free(&a);
+    IntList_free(&b);
+    IntList_free(&c);
+
+    return NULL;
+}
+
+static int int_cmp(const void *a, const void *b)
+{
+    return (*(const int *)a > *(const int *)b) - (*(const int *)a < *(const int *)b);
+}
+
+// Test sorting in place, its stability, and time it against rebuilding from qsort
+char *pak_list_sort_test()
+{
+    static const int NUM_ELEMS = 200000;
+    struct timespec begin, end;
+    double sort_ms, qsort_ms;
+    PairList_node *pn;
+    IntList_node *in;
+    int i, *tmp;
+
+    PairList pairs = PairList_new();
+    IntList list = IntList_new();
+    pak_test_assert(pairs && list, "Failed to create lists.");
+
+    PairList_sort(pairs);
+    pak_test_assert(pairs->count == 0 && !pairs->first, "Sorted an empty list into something.");
+
+    for (i = 0; i < 1000; i++) {
+        Pair p = { rand() % 50, i };
+        PairList_push(pairs, p);
+    }
+
+    PairList_sort(pairs);
+    pak_test_assert(!pairs->first->prev && !pairs->last->next, "Sorted list has loose ends.");
+
+    i = 0;
+    pak_list_foreach(pairs, pn) {
+        if (pn->next) {
+            pak_test_assert(pn->next->prev == pn, "Broken prev link after sort.");
+            pak_test_assert(pn->data.key < pn->next->data.key ||
+                    (pn->data.key == pn->next->data.key && pn->data.seq < pn->next->data.seq),
+                    "Sort is out of order or unstable at %d.", i);
+        }
+        i++;
+    }
+    pak_test_assert(i == 1000 && pairs->count == 1000, "Sort lost nodes.");
+
+    PairList_free(&pairs);
+
+    srand(7);
+    for (i = 0; i < NUM_ELEMS; i++)
+        IntList_push(list, rand());
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    IntList_sort(list);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sort_ms = (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+
+    pak_list_foreach(list, in)
+        pak_test_assert(!in->next || in->data <= in->next->data, "Ints out of order.");
+    pak_test_assert(list->last->data >= list->first->data && list->count == NUM_ELEMS,
+            "Wrong ends after sort.");
+
+    // For comparison, copy out, qsort and rebuild the list node by node.
+    // This is usually faster, the merge sort is for keeping the nodes.
+    srand(7);
+    IntList_free(&list);
+    list = IntList_new();
+    for (i = 0; i < NUM_ELEMS; i++)
+        IntList_push(list, rand());
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    tmp = malloc(NUM_ELEMS * sizeof(*tmp));
+    pak_test_assert(tmp, "Failed to malloc.");
+    i = 0;
+    pak_list_foreach(list, in)
+        tmp[i++] = in->data;
+    qsort(tmp, NUM_ELEMS, sizeof(*tmp), int_cmp);
+    IntList_free(&list);
+    list = IntList_new();
+    for (i = 0; i < NUM_ELEMS; i++)
+        IntList_push(list, tmp[i]);
+    free(tmp);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    qsort_ms = (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+
+    pak_test_debug("Sorted %d ints: %.2f ms merge sort, %.2f ms qsort and rebuild.",
+            NUM_ELEMS, sort_ms, qsort_ms);
 
     IntList_free(&list);
-    pak_test_assert(!list, "List should be NULL after free.");
 
     return NULL;
 }
 
-char *pak_list_gc_test()
+// Time queue traffic through the pool against one malloc and free per node
+char *pak_list_bench_test()
 {
-    static const int NUM_PUSHES = 1000;
-    int i;
+    static const int NUM_OPS = 1000000;
+    static const int BATCH = 64;
+    struct node { int data; struct node *next, *prev; } *head = NULL, *tmp;
+    struct timespec begin, end;
+    double pool_ms, malloc_ms;
+    int i, j;
 
-    GCList list = GCList_new();
-    pak_test_assert(list, "Failed to create GC list.");
+    IntList list = IntList_new();
+    pak_test_assert(list, "Failed to create list.");
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < NUM_OPS; i += BATCH) {
+        for (j = 0; j < BATCH; j++)
+            IntList_push(list, j);
+        for (j = 0; j < BATCH; j++)
+            IntList_shift(list);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    pool_ms = (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
 
-    for (i = 0; i < NUM_PUSHES; i++) {
+    IntList_free(&list);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < NUM_OPS; i += BATCH) {
+        for (j = 0; j < BATCH; j++) {
+            tmp = malloc(sizeof(*tmp));
+            pak_test_assert(tmp, "Failed to malloc.");
+            tmp->data = j;
+            tmp->next = head;
+            head = tmp;
+        }
+        for (j = 0; j < BATCH; j++) {
+            tmp = head->next;
+            free(head);
+            head = tmp;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    malloc_ms = (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+
+    pak_test_debug("%d pushes and shifts: %.2f ms pooled, %.2f ms with malloc.",
+            NUM_OPS, pool_ms, malloc_ms);
+
+    return NULL;
+}
+
+// Test the unrolled list against a plain array doing the same random edits
+char *pak_list_ulist_test()
+{
+    static const int NUM_OPS = 20000;
+    static int ref[20000];
+    int i, j, n = 0, seen = 0;
+    IntUList_node *node;
+
+    IntUList list = IntUList_new();
+    pak_test_assert(list, "Failed to create unrolled list.");
+    pak_test_assert(!IntUList_get(list, 0), "Got from an empty list.");
+
+    srand(42);
+    for (i = 0; i < NUM_OPS; i++) {
+        int op = rand() % 8;
+        int at = n ? rand() % n : 0;
+
+        if (op < 2 || n == 0) {
+            pak_test_assert(IntUList_push(list, i) == 0, "Failed to push.");
+            ref[n++] = i;
+        } else if (op < 3) {
+            pak_test_assert(IntUList_unshift(list, i) == 0, "Failed to unshift.");
+            for (j = n++; j > 0; j--)
+                ref[j] = ref[j - 1];
+            ref[0] = i;
+        } else if (op < 5) {
+            pak_test_assert(IntUList_insert(list, at, i) == 0, "Failed to insert at %d.", at);
+            for (j = n++; j > at; j--)
+                ref[j] = ref[j - 1];
+            ref[at] = i;
+        } else if (op < 6) {
+            pak_test_assert(IntUList_erase(list, at) == 0, "Failed to erase at %d.", at);
+            for (j = at, n--; j < n; j++)
+                ref[j] = ref[j + 1];
+        } else if (op < 7) {
+            IntUList_pop(list);
+            n--;
+        } else {
+            IntUList_shift(list);
+            for (j = 0, n--; j < n; j++)
+                ref[j] = ref[j + 1];
+        }
+
+        pak_test_assert(list->count == n, "Count is %d, not %d.", (int)list->count, n);
+    }
+
+    for (i = 0; i < n; i++)
+        pak_test_assert(*IntUList_get(list, i) == ref[i], "Wrong element at %d.", i);
+    pak_test_assert(*IntUList_get(list, -1) == ref[n - 1], "Wrong last element.");
+    pak_test_assert(!IntUList_get(list, n) && IntUList_insert(list, n + 1, 0) != 0,
+            "Indexed past the end.");
+
+    i = 0;
+    pak_ulist_foreach(list, node, j) {
+        pak_test_assert(node->data[j] == ref[i], "Traversal out of order at %d.", i);
+        i++;
+    }
+    pak_test_assert(i == n, "Traversal visited %d of %d elements.", i, n);
+
+    // Only the last node of a list filled by pushes is not full
+    IntUList_free(&list);
+    list = IntUList_new();
+    for (i = 0; i < 1000; i++)
+        IntUList_push(list, i);
+    pak_list_foreach(list, node)
+        seen += node->next && node->count != PAK__ULIST_CAP(int);
+    pak_test_assert(!seen, "Pushes left nodes partly empty.");
+
+    while (list->count)
+        IntUList_erase(list, list->count / 2);
+    pak_test_assert(!list->first && !list->last, "Erasing everything left nodes.");
+
+    IntUList_free(&list);
+    pak_test_assert(!list, "List should be NULL after free.");
+
+    GCUList gc = GCUList_new();
+    pak_test_assert(gc, "Failed to create GC unrolled list.");
+    for (i = 0; i < 100; i++) {
         int *p = malloc(sizeof(*p));
         *p = i;
+        GCUList_insert(gc, gc->count / 2, p);
+    }
+    GCUList_erase(gc, 10);
+    GCUList_shift(gc);
+    GCUList_pop(gc);
+    GCUList_free(&gc);
 
-        GCList_push(list, p);
+    return NULL;
+}
+
+// Time a full traversal and indexing of a linked and an unrolled list
+char *pak_list_ulist_bench_test()
+{
+    static const int NUM_ELEMS = 1000000;
+    static const int NUM_GETS = 200;
+    struct timespec begin, end;
+    double list_ms, ulist_ms, list_get_ms, ulist_get_ms;
+    long sum_list = 0, sum_ulist = 0;
+    IntList_node *ln;
+    IntUList_node *un;
+    int i, r;
+
+    IntList list = IntList_new();
+    IntUList ulist = IntUList_new();
+    pak_test_assert(list && ulist, "Failed to create lists.");
+
+    for (i = 0; i < NUM_ELEMS; i++) {
+        IntList_push(list, i);
+        IntUList_push(ulist, i);
     }
 
-    GCList_free(&list);
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (r = 0; r < 10; r++)
+        pak_list_foreach(list, ln)
+            sum_list += ln->data;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    list_ms = (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (r = 0; r < 10; r++)
+        pak_ulist_foreach(ulist, un, i)
+            sum_ulist += un->data[i];
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ulist_ms = (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+
+    pak_test_assert(sum_list == sum_ulist, "Traversals disagree.");
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (r = 0; r < NUM_GETS; r++)
+        sum_list += IntList_get(list, (long)r * NUM_ELEMS / NUM_GETS)->data;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    list_get_ms = (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (r = 0; r < NUM_GETS; r++)
+        sum_ulist += *IntUList_get(ulist, (long)r * NUM_ELEMS / NUM_GETS);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ulist_get_ms = (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+
+    pak_test_assert(sum_list == sum_ulist, "Gets disagree.");
+
+    pak_test_debug("Traversals: %.2f ms linked, %.2f ms unrolled. Gets: %.2f ms linked, %.2f ms unrolled.",
+            list_ms, ulist_ms, list_get_ms, ulist_get_ms);
+
+    IntList_free(&list);
+    IntUList_free(&ulist);
+
+    return NULL;
+}
+
+// Test an intrusive list, with the same elements on two lists at once
+char *pak_list_ilist_test()
+{
+    static struct job jobs[10];
+    struct job *j, *tmp;
+    JobList_ owned;
+    int i;
+
+    JobQueue queue = JobQueue_new();
+    pak_test_assert(queue, "Failed to create intrusive list.");
+    pak_test_assert(!JobQueue_first(queue) && !JobQueue_pop(queue) && !JobQueue_shift(queue),
+            "Empty intrusive list has elements.");
+
+    // Lists can also live inside other structs, without being allocated
+    JobList_init(&owned);
+
+    for (i = 0; i < 10; i++) {
+        jobs[i].id = i;
+        pak_test_assert(!JobQueue_linked(&jobs[i]), "Zeroed job is linked.");
+        JobQueue_push(queue, &jobs[i]);
+        JobList_unshift(&owned, &jobs[i]);
+    }
+
+    pak_test_assert(queue->count == 10 && owned.count == 10, "Wrong counts.");
+    pak_test_assert(JobQueue_first(queue) == &jobs[0] && JobQueue_last(queue) == &jobs[9],
+            "Pushed in the wrong order.");
+    pak_test_assert(JobList_first(&owned) == &jobs[9] && JobList_last(&owned) == &jobs[0],
+            "Unshifted in the wrong order.");
+
+    // Removing from one list leaves the element on the other
+    JobQueue_remove(queue, &jobs[5]);
+    pak_test_assert(!JobQueue_linked(&jobs[5]) && JobList_linked(&jobs[5]),
+            "Removal touched the wrong link.");
+    pak_test_assert(JobQueue_next(queue, &jobs[4]) == &jobs[6] &&
+            JobQueue_prev(queue, &jobs[6]) == &jobs[4], "Removal left a gap.");
+
+    JobQueue_insert_after(queue, &jobs[6], &jobs[5]);
+    JobQueue_insert_before(queue, &jobs[0], JobQueue_pop(queue));
+    pak_test_assert(JobQueue_first(queue) == &jobs[9] && JobQueue_last(queue) == &jobs[8],
+            "Failed to move the last job to the front.");
+
+    // Drop the odd jobs while walking the queue
+    pak_ilist_foreach(JobQueue, queue, j, tmp) {
+        if (j->id % 2)
+            JobQueue_remove(queue, j);
+    }
+    pak_test_assert(queue->count == 5, "Queue has %d jobs left.", (int)queue->count);
+
+    i = 0;
+    pak_ilist_foreach(JobQueue, queue, j, tmp) {
+        pak_test_assert(j->id % 2 == 0, "Job %d was not removed.", j->id);
+        i++;
+    }
+    pak_test_assert(i == 5, "Walked %d jobs.", i);
+
+    for (j = JobList_last(&owned), i = 0; j; j = JobList_prev(&owned, j), i++)
+        pak_test_assert(j->id == i, "Owner list out of order at %d.", i);
+
+    JobQueue_free(&queue);
+    pak_test_assert(!queue && !JobQueue_linked(&jobs[0]), "Free did not unlink the jobs.");
+
+    while (JobList_shift(&owned))
+        ;
+    pak_test_assert(owned.count == 0 && !JobList_first(&owned), "Failed to empty list.");
 
     return NULL;
 }
 
 char *pak_list_test()
 {
-    pak_test_run(pak_list_raw_test);
     pak_test_run(pak_list_typesafe_test);
     pak_test_run(pak_list_gc_test);
+    pak_test_run(pak_list_pool_test);
+    pak_test_run(pak_list_splice_test);
+    pak_test_run(pak_list_splice_pools_test);
+    pak_test_run(pak_list_sort_test);
+    pak_test_run(pak_list_bench_test);
+    pak_test_run(pak_list_ulist_test);
+    pak_test_run(pak_list_ulist_bench_test);
+    pak_test_run(pak_list_ilist_test);
 
     return NULL;
 }
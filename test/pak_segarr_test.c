@@ -0,0 +1,137 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "pak_test.h"
+#include "pak_segarr_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pak.h>
+
+PAK_INIT_SEGARR(IntSegArr, int, 4);
+PAK_INIT_SEGARR(BigSegArr, int, 16);
+PAK_INIT_ARR_EX(BigArray, int, NULL, pak_arr_growth_mul(2.0f));
+
+// Test pushing across chunks, indexing and that addresses never move
+char *pak_segarr_basic_test()
+{
+    int i, v;
+    int *first, *middle = NULL;
+
+    IntSegArr seg = IntSegArr_new(0);
+    pak_test_assert(seg, "Failed to create segmented array.");
+    pak_test_assert(IntSegArr_max(seg) == 0, "Empty segmented array has chunks.");
+    pak_test_assert(IntSegArr_pop(seg, &v) != 0, "Popped from an empty segmented array.");
+    pak_test_assert(!IntSegArr_back(seg), "Empty segmented array has a back.");
+
+    IntSegArr_push(seg, 0);
+    first = IntSegArr_get(seg, 0);
+
+    for (i = 1; i < 100; i++) {
+        pak_test_assert(IntSegArr_push(seg, i) == 0, "Failed to push %d.", i);
+        if (i == 50)
+            middle = IntSegArr_get(seg, 50);
+    }
+
+    pak_test_assert(IntSegArr_count(seg) == 100, "Wrong count.");
+    pak_test_assert(IntSegArr_max(seg) == 112, "Chunks hold %d elements.", (int)IntSegArr_max(seg));
+    pak_test_assert(first == IntSegArr_get(seg, 0) && *first == 0, "First element moved.");
+    pak_test_assert(middle == IntSegArr_get(seg, 50) && *middle == 50, "Middle element moved.");
+
+    for (i = 0; i < 100; i++)
+        pak_test_assert(pak_segarr_at(seg, i) == i, "Wrong value at %d.", i);
+
+    pak_test_assert(*IntSegArr_get(seg, -1) == 99 && *IntSegArr_back(seg) == 99, "Wrong back.");
+    pak_test_assert(!IntSegArr_get(seg, 100) && !IntSegArr_get(seg, -101), "Got past the ends.");
+
+    pak_segarr_at(seg, 10) = -10;
+    pak_test_assert(*IntSegArr_get(seg, 10) == -10, "Failed to assign through pak_segarr_at.");
+
+    // Pops keep the chunks until asked to give them back
+    for (i = 99; i >= 20; i--) {
+        pak_test_assert(IntSegArr_pop(seg, &v) == 0 && v == i, "Popped the wrong value.");
+    }
+    pak_test_assert(IntSegArr_max(seg) == 112, "Popping freed chunks.");
+
+    pak_test_assert(IntSegArr_shrink_to_fit(seg) == 0, "Failed to shrink.");
+    pak_test_assert(IntSegArr_max(seg) == 32, "Shrank to %d.", (int)IntSegArr_max(seg));
+    pak_test_assert(first == IntSegArr_get(seg, 0), "Shrinking moved elements.");
+
+    IntSegArr_clear(seg);
+    pak_test_assert(IntSegArr_count(seg) == 0 && IntSegArr_max(seg) == 32, "Failed to clear.");
+
+    pak_test_assert(IntSegArr_reserve(seg, 1000) == 0 && IntSegArr_max(seg) == 1008,
+            "Failed to reserve.");
+
+    IntSegArr_free(&seg);
+    pak_test_assert(!seg, "Segmented array was not set to NULL.");
+
+    return NULL;
+}
+
+static double bench_sec(struct timespec begin, struct timespec end)
+{
+    return (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+}
+
+// Compare the slowest single push of a segmented array against a reallocating one
+char *pak_segarr_push_bench_test()
+{
+    static const int NUM_PUSHES = 10000000;
+    struct timespec begin, end, total;
+    double worst_seg = 0.0, worst_arr = 0.0;
+    int i;
+
+    BigSegArr seg = BigSegArr_new(0);
+    BigArray arr = BigArray_new(16);
+    pak_test_assert(seg && arr, "Failed to create arrays.");
+
+    // Only pushes which start a chunk or fill the array can be slow, so only those are timed
+    clock_gettime(CLOCK_MONOTONIC, &total);
+    for (i = 0; i < NUM_PUSHES; i++) {
+        if ((seg->count & seg->mask) == 0) {
+            clock_gettime(CLOCK_MONOTONIC, &begin);
+            BigSegArr_push(seg, i);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            if (bench_sec(begin, end) > worst_seg)
+                worst_seg = bench_sec(begin, end);
+        } else {
+            BigSegArr_push(seg, i);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    pak_test_debug("Segmented array: %d pushes in %lf sec, slowest %lf sec", NUM_PUSHES,
+            bench_sec(total, end), worst_seg);
+
+    clock_gettime(CLOCK_MONOTONIC, &total);
+    for (i = 0; i < NUM_PUSHES; i++) {
+        if (pak_arr_count(arr) == pak_arr_max(arr)) {
+            clock_gettime(CLOCK_MONOTONIC, &begin);
+            BigArray_push(&arr, i);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            if (bench_sec(begin, end) > worst_arr)
+                worst_arr = bench_sec(begin, end);
+        } else {
+            BigArray_push(&arr, i);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    pak_test_debug("Array: %d pushes in %lf sec, slowest %lf sec", NUM_PUSHES,
+            bench_sec(total, end), worst_arr);
+
+    for (i = 0; i < NUM_PUSHES; i += 9973)
+        pak_test_assert(pak_segarr_at(seg, i) == arr[i], "Wrong value at %d.", i);
+
+    BigSegArr_free(&seg);
+    BigArray_free(&arr);
+
+    return NULL;
+}
+
+char *pak_segarr_test()
+{
+    pak_test_run(pak_segarr_basic_test);
+    pak_test_run(pak_segarr_push_bench_test);
+
+    return NULL;
+}
@@ -0,0 +1,6 @@
+#ifndef PAK_SEGARR_TEST_HEADER
+#define PAK_SEGARR_TEST_HEADER
+
+char *pak_segarr_test();
+
+#endif // PAK_SEGARR_TEST_HEADER